@@ -0,0 +1,328 @@
+#pragma once
+
+#include <vector>
+#include <unordered_set>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+#include "astar.hpp"
+#include "heuristic.hpp"
+
+/* Anytime Repairing A* (ARA*).
+    The search starts with the heuristic inflated by epsilon and publishes the first plan as soon as it is found.
+    Afterwards epsilon is lowered step by step. The supernodes, g_scores and the transposition table are kept
+    between the iterations. Only supernodes whose g_score improved after they were expanded in the current
+    iteration (inconsistent supernodes) are expanded again.
+    Every published plan costs at most bound times the optimal cost.
+    The search stops at the deadline or after the iteration with epsilon = 1, whose plan is optimal.
+**/
+class AnytimeAStarSearch
+{
+public:
+    // Called with the goal supernode of every improved plan and its suboptimality bound.
+    typedef std::function<void(Node *, double)> Callback;
+
+    AnytimeAStarSearch(config::SearchOptions options = config::SearchOptions(), Heuristic *heuristic = nullptr);
+
+    // Search function
+    Node *search(Graph<> *, Node *, NodeExpander *, const Callback & = Callback());
+
+    const SearchStatistics &statistics() const;
+
+    // Suboptimality bound of the plan returned by the last search. INFINITY if no plan was found.
+    double publishedBound() const;
+
+private:
+    bool improvePath(NodeExpander *);
+    void push(Node *);
+    void rebuildOpenSet();
+    double bound() const;
+    bool expired() const;
+    void publish(double);
+
+    double calcHScore(Node *) const;
+
+    // Open-set as binary heap, so it can be reordered when epsilon changes.
+    std::vector<Node *> open_;
+
+    // Supernodes expanded in the current iteration.
+    std::unordered_set<Node *> closed_;
+
+    // Supernodes improved after their state was expanded in the current iteration.
+    // They are moved into the open-set when the next iteration starts.
+    std::vector<Node *> inconsistent_;
+
+    TranspositionTable transpositions_;
+
+    // Best goal found so far.
+    Node *incumbent_;
+
+    // Callback of the running search, the last published plan and its bound.
+    // A plan is only published again if it or its bound improved.
+    const Callback *callback_;
+    Node *published_;
+    double published_bound_;
+
+    double epsilon_;
+    double initial_epsilon_;
+    double epsilon_step_;
+
+    // Start with the plan of the greedy descent as incumbent.
+    bool seed_incumbent_;
+
+    // Time budget. Zero means no deadline.
+    std::chrono::milliseconds time_limit_;
+    std::chrono::steady_clock::time_point deadline_;
+
+    Heuristic *heuristic_;
+    SearchStatistics statistics_;
+};
+
+/* Constructor
+    @options: initial_epsilon: weight of the heuristic in the first iteration. Values below 1 are raised to 1.
+              epsilon_step: amount epsilon is lowered by after each iteration.
+              deadline: time budget of the search in milliseconds. Zero for no limit.
+                        The search does not stop before the first plan is found.
+              seed_incumbent: if true, the plan of the greedy descent is the first incumbent.
+    @heuristic: admissible heuristic. If nullptr, zero is used and every iteration is a uniform-cost search.
+                The legacy heuristic needs the expansion of a supernode before it is queued and is not supported.
+**/
+AnytimeAStarSearch::AnytimeAStarSearch(config::SearchOptions options, Heuristic *heuristic)
+{
+    initial_epsilon_ = std::max(options.initial_epsilon, 1.0);
+    epsilon_step_ = options.epsilon_step;
+    seed_incumbent_ = options.seed_incumbent;
+    time_limit_ = std::chrono::milliseconds(options.deadline);
+    heuristic_ = heuristic;
+    incumbent_ = nullptr;
+    callback_ = nullptr;
+    published_ = nullptr;
+    published_bound_ = INFINITY;
+    epsilon_ = initial_epsilon_;
+}
+
+/* Perform the anytime search.
+    @graph: pointer to graph on which the search should be performed.
+    @root: pointer to node at which the search should begin.
+    @exapnder: exapnder object used for node expansion.
+    @callback: called for every improved plan or bound with the goal supernode and the suboptimality bound.
+               An improved plan is published as soon as it is found, including the plan of the greedy descent.
+               The goal stays valid until the search graph is destroyed.
+    \return: the best goal supernode found before the deadline. The root if no goal was found.
+**/
+Node *AnytimeAStarSearch::search(Graph<> *graph, Node *root, NodeExpander *expander, const Callback &callback)
+{
+    deadline_ = std::chrono::steady_clock::now() + time_limit_;
+    open_.clear();
+    closed_.clear();
+    inconsistent_.clear();
+    transpositions_.clear();
+    statistics_ = SearchStatistics();
+    incumbent_ = nullptr;
+    callback_ = &callback;
+    published_ = nullptr;
+    published_bound_ = INFINITY;
+    epsilon_ = initial_epsilon_;
+
+    root->data_.g_score = 0;
+    root->data_.h_score = calcHScore(root);
+    transpositions_.insert(root, statistics_);
+    if (root->data_.isGoal())
+    {
+        incumbent_ = root;
+    }
+    else
+    {
+        push(root);
+        if (seed_incumbent_)
+        {
+            incumbent_ = greedyDescent(graph, root, expander, statistics_);
+            publish(bound());
+        }
+    }
+
+    while (true)
+    {
+        bool completed = improvePath(expander);
+
+        // The plan of an interrupted iteration is valid, but its bound is only known through the open-set.
+        double current_bound = std::min(epsilon_, bound());
+        publish(current_bound);
+
+        if (!completed || current_bound <= 1 || epsilon_ <= 1 || (open_.empty() && inconsistent_.empty()))
+            break;
+
+        // Lower epsilon and restart the search with the inconsistent supernodes.
+        epsilon_ = std::max(epsilon_ - epsilon_step_, 1.0);
+        closed_.clear();
+        for (auto node : inconsistent_)
+            open_.push_back(node);
+        inconsistent_.clear();
+        rebuildOpenSet();
+    }
+
+    return incumbent_ ? incumbent_ : root;
+}
+
+/* Run one ARA* iteration with the current epsilon.
+    Expands supernodes until no supernode in the open-set can improve the incumbent.
+    The deadline is only checked once a plan is known, so the first plan is always returned.
+    @expander: exapnder object used for node expansion.
+    \return: false if the deadline expired, true otherwise.
+**/
+bool AnytimeAStarSearch::improvePath(NodeExpander *expander)
+{
+    while (!open_.empty())
+    {
+        statistics_.peak_open = std::max(statistics_.peak_open, open_.size());
+        Node *current = open_.front();
+        if (incumbent_ && incumbent_->data_.g_score <= current->data_.f_score)
+            break;
+
+        if (incumbent_ && expired())
+            return false;
+
+        std::pop_heap(open_.begin(), open_.end(), LessThan());
+        open_.pop_back();
+
+        // Skip supernodes replaced by a better one for the same state and supernodes expanded before.
+        if (transpositions_.find(current) != current || current->data_.marked)
+            continue;
+
+        // An improved state is always reached through a new supernode, so no supernode is expanded twice.
+        expander->expandNode(current);
+        current->data_.marked = true;
+        statistics_.expansions++;
+        statistics_.generated += current->numberOfSuccessors();
+        closed_.insert(current);
+
+        bool improved = false;
+        for (auto edge : current->successors())
+        {
+            Node *child = edge->getDestination();
+            child->data_.g_score = current->data_.g_score + edge->data_.cost;
+
+            // The state of the replaced supernode decides whether the child was closed in this iteration.
+            Node *known = transpositions_.find(child);
+            if (!transpositions_.insert(child, statistics_))
+                continue;
+
+            child->data_.h_score = calcHScore(child);
+            if (child->data_.isGoal())
+            {
+                if (!incumbent_ || child->data_.g_score < incumbent_->data_.g_score)
+                {
+                    incumbent_ = child;
+                    improved = true;
+                }
+            }
+            else if (known && closed_.count(known))
+            {
+                inconsistent_.push_back(child);
+            }
+            else
+            {
+                push(child);
+            }
+        }
+
+        // Published once all children are queued, as the bound is derived from the open-set.
+        if (improved)
+            publish(bound());
+    }
+    return true;
+}
+
+/* Push a supernode onto the open-set. The key is the g_score plus the inflated h_score.
+**/
+void AnytimeAStarSearch::push(Node *node)
+{
+    node->data_.f_score = node->data_.g_score + epsilon_ * node->data_.h_score;
+    open_.push_back(node);
+    std::push_heap(open_.begin(), open_.end(), LessThan());
+    statistics_.queued++;
+}
+
+/* Recompute the keys of the open-set for the current epsilon.
+    Supernodes replaced by a better one are dropped.
+**/
+void AnytimeAStarSearch::rebuildOpenSet()
+{
+    std::size_t kept = 0;
+    for (auto node : open_)
+    {
+        if (transpositions_.find(node) != node || node->data_.marked)
+            continue;
+        node->data_.f_score = node->data_.g_score + epsilon_ * node->data_.h_score;
+        open_[kept++] = node;
+    }
+    open_.resize(kept);
+    std::make_heap(open_.begin(), open_.end(), LessThan());
+}
+
+/* Suboptimality bound of the incumbent.
+    The optimal cost is at least the lowest g_score + h_score among the open and inconsistent supernodes.
+    \return: ratio of the incumbent cost and this lower bound. INFINITY if there is no incumbent.
+**/
+double AnytimeAStarSearch::bound() const
+{
+    if (!incumbent_)
+        return INFINITY;
+
+    double lower_bound = incumbent_->data_.g_score;
+    for (auto list : {&open_, &inconsistent_})
+    {
+        for (auto node : *list)
+        {
+            if (transpositions_.find(node) != node || node->data_.marked)
+                continue;
+            lower_bound = std::min(lower_bound, node->data_.g_score + node->data_.h_score);
+        }
+    }
+
+    if (lower_bound <= 0)
+        return incumbent_->data_.g_score <= 0 ? 1 : INFINITY;
+    return incumbent_->data_.g_score / lower_bound;
+}
+
+/* Publish the incumbent through the callback of the running search, if it or its bound improved.
+    @current_bound: suboptimality bound of the incumbent known at this moment.
+**/
+void AnytimeAStarSearch::publish(double current_bound)
+{
+    if (!incumbent_ || (incumbent_ == published_ && current_bound >= published_bound_))
+        return;
+
+    published_ = incumbent_;
+    published_bound_ = current_bound;
+    if (*callback_)
+        (*callback_)(incumbent_, current_bound);
+}
+
+/* Check if the deadline has passed.
+**/
+bool AnytimeAStarSearch::expired() const
+{
+    return time_limit_.count() > 0 && std::chrono::steady_clock::now() >= deadline_;
+}
+
+/* Calculate the h_score of a supernode which is not expanded yet.
+**/
+double AnytimeAStarSearch::calcHScore(Node *node) const
+{
+    return heuristic_ ? (*heuristic_)(node->data_) : 0;
+}
+
+/* Get the counters collected during the last search.
+**/
+const SearchStatistics &AnytimeAStarSearch::statistics() const
+{
+    return statistics_;
+}
+
+double AnytimeAStarSearch::publishedBound() const
+{
+    return published_bound_;
+}
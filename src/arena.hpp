@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <algorithm>
+
+// Size of the blocks requested by an Arena. Larger objects obtain a block of their own.
+#ifndef ARENA_BLOCK_SIZE
+#define ARENA_BLOCK_SIZE (1 << 20)
+#endif
+
+/* Bump allocator for objects with the same lifetime.
+    Memory is handed out from large blocks by advancing an offset.
+    Single objects are never freed, all blocks are released at once by release() or the destructor.
+    The Arena does not call destructors. The owner of the objects has to destroy them
+    before the memory is released.
+**/
+class Arena
+{
+public:
+    Arena(std::size_t block_size = ARENA_BLOCK_SIZE);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Obtain uninitialized memory.
+    void *allocate(std::size_t, std::size_t);
+
+    // Construct an object inside the arena.
+    template <typename T, typename... Args>
+    T *create(Args &&...);
+
+    // Release all blocks.
+    void release();
+
+    // Memory statistics in bytes.
+    std::size_t used() const;
+    std::size_t reserved() const;
+    std::size_t peak() const;
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::size_t block_size_;
+
+    // Free memory of the current block.
+    char *current_;
+    std::size_t remaining_;
+
+    std::size_t used_;
+    std::size_t reserved_;
+    std::size_t peak_;
+};
+
+/* Constructor. No memory is requested before the first allocation.
+    @block_size: size of the blocks requested from the system.
+**/
+inline Arena::Arena(std::size_t block_size)
+{
+    block_size_ = block_size;
+    current_ = nullptr;
+    remaining_ = 0;
+    used_ = 0;
+    reserved_ = 0;
+    peak_ = 0;
+}
+
+/* Destructor. Releases all blocks.
+**/
+inline Arena::~Arena()
+{
+    release();
+}
+
+/* Obtain uninitialized memory.
+    @size: number of bytes.
+    @alignment: alignment of the memory. Has to be a power of two.
+    \return: pointer to the memory. Valid until release() is called.
+**/
+inline void *
+Arena::allocate(std::size_t size, std::size_t alignment)
+{
+    std::size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(current_) % alignment) % alignment;
+    if (current_ == nullptr || padding + size > remaining_)
+    {
+        std::size_t block_size = std::max(block_size_, size + alignment);
+        blocks_.emplace_back(new char[block_size]);
+        current_ = blocks_.back().get();
+        remaining_ = block_size;
+        reserved_ += block_size;
+        padding = (alignment - reinterpret_cast<std::uintptr_t>(current_) % alignment) % alignment;
+    }
+
+    void *memory = current_ + padding;
+    current_ += padding + size;
+    remaining_ -= padding + size;
+
+    used_ += padding + size;
+    peak_ = std::max(peak_, used_);
+    return memory;
+}
+
+/* Construct an object inside the arena.
+    @args: arguments forwarded to the constructor of T.
+    \return: pointer to the object. Has to be destroyed by calling its destructor explicitly.
+**/
+template <typename T, typename... Args>
+inline T *
+Arena::create(Args &&...args)
+{
+    return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+}
+
+/* Release all blocks at once. Every pointer obtained from the arena becomes invalid.
+    The peak usage is kept.
+**/
+inline void
+Arena::release()
+{
+    blocks_.clear();
+    current_ = nullptr;
+    remaining_ = 0;
+    used_ = 0;
+    reserved_ = 0;
+}
+
+/* Number of bytes handed out since the last release.
+**/
+inline std::size_t
+Arena::used() const
+{
+    return used_;
+}
+
+/* Number of bytes requested from the system since the last release.
+**/
+inline std::size_t
+Arena::reserved() const
+{
+    return reserved_;
+}
+
+/* Largest number of bytes handed out at the same time.
+**/
+inline std::size_t
+Arena::peak() const
+{
+    return peak_;
+}
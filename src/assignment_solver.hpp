@@ -0,0 +1,231 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+/* Min-cost bipartite matching on a dense cost matrix (Hungarian method).
+    Used by NodeExpander::expandBest to choose the cheapest step which keeps as many agents busy as possible.
+    Rows are the open subassemblies of a supernode, columns the agents. Every row and every column
+    is matched at most once, as an agent executes one action per step and a subassembly is consumed by one action.
+    The matching is grown by one pair at a time along a shortest augmenting path (successive shortest paths).
+    With the potentials of the rows and columns the reduced costs stay non-negative, so the paths are found
+    by a dense Dijkstra. After m augmentations the matching is the cheapest one with m pairs.
+    Therefore a single run yields the cheapest matchings of all sizes up to min(rows, columns).
+    The costs have to be finite. The matrix is stored row-major, the relaxation of a row is a branch-free
+    loop over contiguous columns, which the compiler vectorizes.
+    The buffers are kept between the runs, so a solver should be reused.
+**/
+class AssignmentSolver
+{
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // Compute the cheapest matchings of every size of a rows x columns matrix.
+    void solve(const double *, std::size_t, std::size_t);
+
+    // Number of pairs of the largest matching, min(rows, columns).
+    std::size_t size() const;
+
+    // Summed cost of the cheapest matching with the given number of pairs.
+    double cost(std::size_t) const;
+
+    // Column matched to a row in the largest matching. npos if the row is not matched.
+    std::size_t column(std::size_t) const;
+
+private:
+    bool augment();
+
+    const double *matrix_;
+    std::size_t rows_ = 0;
+    std::size_t columns_ = 0;
+
+    // Potentials of the rows, the columns and the sink. The one of the source stays zero.
+    std::vector<double> row_potential_;
+    std::vector<double> column_potential_;
+    double sink_potential_;
+
+    // Reduced distances of the current Dijkstra, the row preceding every column on its shortest path
+    // and the flags of the rows and columns whose distance is final.
+    std::vector<double> row_distance_;
+    std::vector<double> column_distance_;
+    std::vector<std::size_t> column_parent_;
+    std::vector<char> row_done_;
+    std::vector<char> column_done_;
+
+    std::vector<std::size_t> row_match_;
+    std::vector<std::size_t> column_match_;
+
+    // costs_[m]: summed cost of the cheapest matching with m pairs.
+    std::vector<double> costs_;
+};
+
+/* Compute the cheapest matchings of every size.
+    @matrix: row-major cost matrix, matrix[row * columns + column]. Has to stay valid until solve returns.
+    @rows: number of rows.
+    @columns: number of columns.
+**/
+void AssignmentSolver::solve(const double *matrix, std::size_t rows, std::size_t columns)
+{
+    matrix_ = matrix;
+    rows_ = rows;
+    columns_ = columns;
+
+    row_match_.assign(rows_, npos);
+    column_match_.assign(columns_, npos);
+    costs_.assign(1, 0);
+    if (rows_ == 0 || columns_ == 0)
+        return;
+
+    // Initial potentials are the distances from the source: a column is reached through its cheapest row.
+    row_potential_.assign(rows_, 0);
+    column_potential_.assign(matrix_, matrix_ + columns_);
+    for (std::size_t row = 1; row < rows_; row++)
+    {
+        const double *costs = matrix_ + row * columns_;
+        for (std::size_t column = 0; column < columns_; column++)
+            column_potential_[column] = std::min(column_potential_[column], costs[column]);
+    }
+    sink_potential_ = *std::min_element(column_potential_.begin(), column_potential_.end());
+
+    row_distance_.resize(rows_);
+    column_distance_.resize(columns_);
+    column_parent_.resize(columns_);
+    row_done_.resize(rows_);
+    column_done_.resize(columns_);
+
+    std::size_t pairs = std::min(rows_, columns_);
+    while (costs_.size() <= pairs && augment())
+    {
+        // The potential of the sink is the length of the shortest augmenting path.
+        costs_.push_back(costs_.back() + sink_potential_);
+    }
+}
+
+/* Add one pair to the matching along the shortest augmenting path.
+    The path starts at an unmatched row, alternates between unmatched and matched pairs and ends at an unmatched column.
+    \return: false if there is no augmenting path.
+**/
+bool AssignmentSolver::augment()
+{
+    // Unmatched rows are connected to the source. Their potential is zero, so their reduced distance is zero as well.
+    for (std::size_t row = 0; row < rows_; row++)
+        row_distance_[row] = row_match_[row] == npos ? -row_potential_[row] : INFINITY;
+    std::fill(column_distance_.begin(), column_distance_.end(), INFINITY);
+    std::fill(column_parent_.begin(), column_parent_.end(), npos);
+    std::fill(row_done_.begin(), row_done_.end(), 0);
+    std::fill(column_done_.begin(), column_done_.end(), 0);
+
+    double sink_distance = INFINITY;
+    std::size_t sink_column = npos;
+
+    while (true)
+    {
+        // Closest row or column whose distance is not final.
+        double best = INFINITY;
+        std::size_t best_row = npos;
+        std::size_t best_column = npos;
+        for (std::size_t row = 0; row < rows_; row++)
+        {
+            if (!row_done_[row] && row_distance_[row] < best)
+            {
+                best = row_distance_[row];
+                best_row = row;
+            }
+        }
+        for (std::size_t column = 0; column < columns_; column++)
+        {
+            if (!column_done_[column] && column_distance_[column] < best)
+            {
+                best = column_distance_[column];
+                best_row = npos;
+                best_column = column;
+            }
+        }
+        if (best >= sink_distance)
+            break;
+
+        if (best_row != npos)
+        {
+            // Relax the edges to all columns. The column matched to this row is final already.
+            row_done_[best_row] = 1;
+            const double *costs = matrix_ + best_row * columns_;
+            double offset = best + row_potential_[best_row];
+            for (std::size_t column = 0; column < columns_; column++)
+            {
+                double distance = offset + costs[column] - column_potential_[column];
+                bool shorter = (distance < column_distance_[column]) & !column_done_[column];
+                column_distance_[column] = shorter ? distance : column_distance_[column];
+                column_parent_[column] = shorter ? best_row : column_parent_[column];
+            }
+        }
+        else
+        {
+            column_done_[best_column] = 1;
+            std::size_t row = column_match_[best_column];
+            if (row == npos)
+            {
+                // Unmatched columns are connected to the sink.
+                double distance = best + column_potential_[best_column] - sink_potential_;
+                if (distance < sink_distance)
+                {
+                    sink_distance = distance;
+                    sink_column = best_column;
+                }
+            }
+            else if (!row_done_[row])
+            {
+                // The matched pair is traversed backwards, its reduced cost is zero.
+                double distance = best - matrix_[row * columns_ + best_column] + column_potential_[best_column] - row_potential_[row];
+                row_distance_[row] = std::min(row_distance_[row], distance);
+            }
+        }
+    }
+
+    if (sink_column == npos)
+        return false;
+
+    // Nodes which were not reached before the sink keep their reduced costs non-negative with the distance of the sink.
+    for (std::size_t row = 0; row < rows_; row++)
+        row_potential_[row] += std::min(row_distance_[row], sink_distance);
+    for (std::size_t column = 0; column < columns_; column++)
+        column_potential_[column] += std::min(column_distance_[column], sink_distance);
+    sink_potential_ += sink_distance;
+
+    // Flip the pairs along the path, starting at the sink.
+    std::size_t column = sink_column;
+    while (column != npos)
+    {
+        std::size_t row = column_parent_[column];
+        std::size_t previous = row_match_[row];
+        row_match_[row] = column;
+        column_match_[column] = row;
+        column = previous;
+    }
+    return true;
+}
+
+inline std::size_t
+AssignmentSolver::size() const
+{
+    return costs_.size() - 1;
+}
+
+/* Summed cost of the cheapest matching with the given number of pairs.
+    @pairs: number of pairs, at most size().
+**/
+inline double
+AssignmentSolver::cost(std::size_t pairs) const
+{
+    return costs_[pairs];
+}
+
+/* Column matched to a row in the largest matching.
+    @row: index of the row.
+**/
+inline std::size_t
+AssignmentSolver::column(std::size_t row) const
+{
+    return row_match_[row];
+}
@@ -4,9 +4,15 @@
 #include <climits>
 #include <set>
 #include <vector>
-#include <queue>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
 
 #include "expander.hpp"
+#include "heuristic.hpp"
+#include "indexed_heap.hpp"
+#include "score_kernel.hpp"
 
 /* Comparator function.
     Used to sort the priosirty queue inside AStarSearch.
@@ -20,6 +26,81 @@ struct LessThan
     }
 };
 
+/* Counters collected during a search.
+    Used to compare the work done by the different expansion modes.
+**/
+struct SearchStatistics
+{
+    // Number of calls to NodeExpander::expandNode or NodeExpander::expandNodePartial.
+    std::size_t expansions = 0;
+    // Number of successor supernodes created by these expansions.
+    std::size_t generated = 0;
+    // Number of supernodes pushed onto the open-set.
+    std::size_t queued = 0;
+    // Number of supernodes discarded as duplicates of an already known state.
+    std::size_t duplicates = 0;
+    // Largest number of supernodes waiting in the open-set (beam, or search path for IDA*) at the same time.
+    std::size_t peak_open = 0;
+};
+
+/* Outcome of a search.
+    Everything but Solved means that the returned supernode is not a goal, but the best partial plan found.
+**/
+enum class SearchStatus
+{
+    Solved,
+    // The open-set ran empty without reaching a goal.
+    Exhausted,
+    TimeLimit,
+    ExpansionLimit,
+    MemoryLimit,
+    // The memory-bounded search needs more supernodes than its budget on a single path.
+    NodeBudget
+};
+
+inline const char *toString(SearchStatus status)
+{
+    switch (status)
+    {
+    case SearchStatus::Solved:
+        return "solved";
+    case SearchStatus::Exhausted:
+        return "exhausted";
+    case SearchStatus::TimeLimit:
+        return "time limit";
+    case SearchStatus::ExpansionLimit:
+        return "expansion limit";
+    case SearchStatus::MemoryLimit:
+        return "memory limit";
+    case SearchStatus::NodeBudget:
+        return "node budget";
+    }
+    return "unknown";
+}
+
+/* Transposition table of the A* search.
+    Maps the hash of the SearchState to the best supernode reaching that state.
+    The same set of remaining subassemblies is reached through many action orders and agent permutations.
+    Equivalent supernodes are merged, only the one with the best g_score is kept.
+**/
+class TranspositionTable
+{
+public:
+    // Lookup of the best supernode found for a given state.
+    Node *find(Node *) const;
+
+    // Insert a supernode. Returns false if the state is already reached with a lower or equal g_score.
+    bool insert(Node *, SearchStatistics &, Node ** = nullptr);
+
+    void clear();
+
+private:
+    std::unordered_multimap<std::size_t, Node *> table_;
+};
+
+// Plan which follows the cheapest widest assignment of every step. First incumbent of the non-optimal searches.
+Node *greedyDescent(Graph<> *, Node *, NodeExpander *, SearchStatistics &);
+
 /* Class representing the A* Search Algorithm.
     It executes the search on a given graph.
     The provided Exapander-Object is used to perform the Node-Expansion step.
@@ -27,20 +108,92 @@ struct LessThan
 class AStarSearch
 {
 private:
-    /* data */
+    // Transposition table. Maps the hash of the SearchState to the best supernode reaching that state.
+    TranspositionTable transpositions_;
+
+    // Expand supernodes when they are popped from the open-set instead of when they are pushed.
+    // In this mode NodeData::marked denotes that a supernode has been expanded.
+    bool lazy_expansion_;
+
+    // Create the successors of a supernode in ascending order of their edge cost.
+    // A popped supernode only creates the successors which do not exceed its f_score.
+    // It is pushed again with the f_score of the cheapest successor not created yet.
+    bool partial_expansion_;
+
+    Node *searchPartial(Graph<> *, Node *, NodeExpander *);
+
+    // Successors created by the last partial expansion.
+    std::vector<Node *> created_;
+
+    // Children of the last expansion which are pushed onto the open-set at once.
+    // Set if a replaced supernode was not queued. It may be one of the children, which are filtered then.
+    std::vector<Node *> children_;
+    bool children_replaced_;
+    void pushChildren(IndexedHeap<LessThan> &);
+
+    // Scores of the children of the last expansion. Evaluated in one pass before they are pushed.
+    ScoreBatch batch_;
+    void scoreChildren(bool, NodeExpander *);
+
+    // Insert a supernode into the transposition table. A queued supernode it replaces is removed from the open-set.
+    bool insertState(Node *, IndexedHeap<LessThan> &);
+
+    // Heuristic used for the h_score. If not set, NodeData::calc_hscore is used.
+    Heuristic *heuristic_;
+
+    void calcHScore(Node *, NodeExpander *);
+
+    // Limits of the search. Zero means no limit.
+    std::chrono::milliseconds time_limit_;
+    std::size_t expansion_limit_;
+    std::size_t memory_limit_;
+    std::chrono::steady_clock::time_point deadline_;
+
+    bool limitReached(Graph<> *);
+    void recordPartial(Node *);
+    Node *stop(SearchStatus);
+
+    // Best partial plan: the deepest supernode taken from the open-set, ties broken by the lower f_score.
+    Node *best_partial_;
+    SearchStatus status_;
+
+    SearchStatistics statistics_;
+
 public:
     // Constructor, Destructor
-    AStarSearch();
+    AStarSearch(config::SearchOptions options = config::SearchOptions(), Heuristic *heuristic = nullptr);
     ~AStarSearch();
 
     // Search function
     Node *search(Graph<> *, Node *, NodeExpander *);
+
+    const SearchStatistics &statistics() const;
+
+    // Outcome of the last search.
+    SearchStatus status() const;
 };
 
 /* Constructor
+    @options: lazy_expansion: if true, supernodes are expanded when they leave the open-set.
+                              Children are pushed with a zero h_score, which is replaced once they are expanded.
+              partial_expansion: if true, supernodes create their successors in ascending order of the edge cost.
+                                 Takes precedence over lazy_expansion.
+              time_limit, expansion_limit, memory_limit: limits of the search. If one is reached,
+                                                        the best partial plan is returned.
+    @heuristic: admissible heuristic. It does not depend on the expansion of a supernode,
+                so lazy and partial expansion use it instead of the zero lower bound.
+                If nullptr, the legacy NodeData::calc_hscore is used.
 **/
-AStarSearch::AStarSearch(/* args */)
+AStarSearch::AStarSearch(config::SearchOptions options, Heuristic *heuristic)
 {
+    lazy_expansion_ = options.lazy_expansion;
+    partial_expansion_ = options.partial_expansion;
+    heuristic_ = heuristic;
+    time_limit_ = std::chrono::milliseconds(options.time_limit);
+    expansion_limit_ = options.expansion_limit;
+    memory_limit_ = options.memory_limit;
+    best_partial_ = nullptr;
+    status_ = SearchStatus::Exhausted;
 }
 
 /* Destructor
@@ -53,46 +206,407 @@ AStarSearch::~AStarSearch()
     @graph: pointer to graph on which the search should be performed.
     @root: pointer to node at which the search should begin.
     @exapnder: exapnder object used for node expansion.
+    \return: the goal supernode if status() is Solved. Otherwise the best partial plan.
 **/
 Node *AStarSearch::search(Graph<> *graph, Node *root, NodeExpander *expander)
 {
 
     Node *current = nullptr;
-    std::priority_queue<Node *, std::vector<Node *>, LessThan> openSet;
+    IndexedHeap<LessThan> openSet;
+
+    // The same set of remaining subassemblies is reached through many action orders and agent permutations.
+    // Equivalent supernodes are merged using the transposition table, only the one with the best g_score is kept.
+    transpositions_.clear();
+    statistics_ = SearchStatistics();
+    deadline_ = std::chrono::steady_clock::now() + time_limit_;
+    best_partial_ = root;
+
+    transpositions_.insert(root, statistics_);
+
+    if (partial_expansion_)
+    {
+        return searchPartial(graph, root, expander);
+    }
 
-    // Closed-Set is redundant as the search is performed on a acyclic graph where every path is unique.
-    // -> Nodes can only be reached in one way.
-    // Not using the closed-set saves some processing time needed to lookuo-stuff.
-    // NodeSet closedSet; 
     expander->expandNode(root);
-    root->data_.calc_hscore();
+    statistics_.expansions++;
+    statistics_.generated += root->numberOfSuccessors();
+    root->data_.marked = true;
+    calcHScore(root, expander);
     root->data_.calc_fscore();
 
     openSet.push(root);
+    statistics_.queued++;
 
     while (!openSet.empty())
     {
+        statistics_.peak_open = std::max(statistics_.peak_open, openSet.size());
         current = openSet.top();
         openSet.pop();
 
         if (current->data_.isGoal())
         {
+            status_ = SearchStatus::Solved;
             return current;
         }
-        
+
+        recordPartial(current);
+        if (limitReached(graph))
+        {
+            return best_partial_;
+        }
+
+        // In lazy mode only the supernodes leaving the open-set are expanded.
+        // Most of the pushed supernodes are never popped and are never expanded.
+        if (lazy_expansion_ && !current->data_.marked)
+        {
+            current->data_.marked = true;
+
+            // The expansion provides the exact h_score, which replaces the lower bound used when it was pushed.
+            // If the f_score increased, the supernode has to wait for its turn in the open-set again.
+            double estimated_f_score = current->data_.f_score;
+            expander->expandNode(current);
+            statistics_.expansions++;
+            statistics_.generated += current->numberOfSuccessors();
+
+            calcHScore(current, expander);
+            current->data_.calc_fscore();
+            if (current->data_.f_score > estimated_f_score)
+            {
+                openSet.push(current);
+                statistics_.queued++;
+                continue;
+            }
+        }
         current->data_.marked = true;
 
-        for (auto &edge : current->getSuccessors())
+        children_.clear();
+        children_replaced_ = false;
+        for (auto edge : current->successors())
         {
             Node *child = edge->getDestination();
-            expander->expandNode(child);
-
             child->data_.g_score = current->data_.g_score + edge->data_.cost;
-            child->data_.calc_hscore();
+
+            // Skip the child if the state is already reached with a lower or equal cost.
+            if (!insertState(child, openSet))
+            {
+                continue;
+            }
+
+            // In lazy mode the child is not expanded yet.
+            if (!lazy_expansion_)
+            {
+                expander->expandNode(child);
+                statistics_.expansions++;
+                statistics_.generated += child->numberOfSuccessors();
+            }
+            children_.push_back(child);
+        }
+        scoreChildren(!lazy_expansion_, expander);
+        pushChildren(openSet);
+    }
+    return stop(SearchStatus::Exhausted);
+}
+
+/* Perform the A* graph search with partial expansion.
+    A popped supernode only creates the successors whose f_score does not exceed its own f_score.
+    Their h_score is not known yet, zero is used as a lower bound until they are popped themselves.
+    If successors remain, the supernode is pushed again with the lowest f_score among them.
+    @graph: pointer to graph on which the search should be performed.
+    @root: pointer to node at which the search should begin. Already inserted into the transposition table.
+    @exapnder: exapnder object used for node expansion.
+**/
+Node *AStarSearch::searchPartial(Graph<> *graph, Node *root, NodeExpander *expander)
+{
+    Node *current = nullptr;
+    IndexedHeap<LessThan> openSet;
+
+    root->data_.h_score = 0;
+    if (heuristic_)
+        calcHScore(root, expander);
+    root->data_.calc_fscore();
+    openSet.push(root);
+    statistics_.queued++;
+
+    while (!openSet.empty())
+    {
+        statistics_.peak_open = std::max(statistics_.peak_open, openSet.size());
+        current = openSet.top();
+        openSet.pop();
+
+        if (current->data_.isGoal())
+        {
+            status_ = SearchStatus::Solved;
+            return current;
+        }
+
+        recordPartial(current);
+        if (limitReached(graph))
+        {
+            return best_partial_;
+        }
+
+        created_.clear();
+        double next_cost = expander->expandNodePartial(current, current->data_.f_score - current->data_.g_score, created_);
+        statistics_.expansions++;
+        statistics_.generated += created_.size();
+
+        // Every partial expansion ranks all assignments, so the h_score is exact from now on.
+        current->data_.marked = true;
+        calcHScore(current, expander);
+
+        children_.clear();
+        children_replaced_ = false;
+        for (auto child : created_)
+        {
+            child->data_.g_score = current->data_.g_score + child->predecessors().front()->data_.cost;
+
+            // Skip the child if the state is already reached with a lower or equal cost.
+            if (!insertState(child, openSet))
+            {
+                continue;
+            }
+
+            children_.push_back(child);
+        }
+        scoreChildren(false, expander);
+        pushChildren(openSet);
+
+        if (next_cost != INFINITY)
+        {
+            current->data_.f_score = current->data_.g_score + std::max(current->data_.h_score, next_cost);
+            openSet.push(current);
+            statistics_.queued++;
+        }
+    }
+    return stop(SearchStatus::Exhausted);
+}
+
+/* Insert a supernode into the transposition table.
+    The open-set only contains the best supernode of every state, a queued supernode replaced by a better one is removed.
+    @node: supernode with a valid g_score.
+    @open_set: open-set of the search.
+    \return: false if the state is already reached with a lower or equal g_score.
+**/
+bool AStarSearch::insertState(Node *node, IndexedHeap<LessThan> &open_set)
+{
+    Node *replaced;
+    if (!transpositions_.insert(node, statistics_, &replaced))
+        return false;
+    if (replaced && open_set.contains(replaced))
+        open_set.remove(replaced);
+    else if (replaced)
+        children_replaced_ = true;
+    return true;
+}
+
+/* Calculate the h_score and f_score of the children of the last expansion.
+    With the heuristic, the components are gathered per child and combined for all children in one pass
+    by the vectorized kernel of this CPU (scoreBatch).
+    The legacy h_score is evaluated per child. It is not known before the expansion,
+    zero is a lower bound then, so the child is popped no later than in the eager mode.
+    @expanded: true if the children are expanded already.
+    @expander: expander which resolves the subassemblies for the legacy h_score.
+**/
+void AStarSearch::scoreChildren(bool expanded, NodeExpander *expander)
+{
+    if (!heuristic_)
+    {
+        for (auto child : children_)
+        {
+            if (expanded)
+                calcHScore(child, expander);
+            else
+                child->data_.h_score = 0;
             child->data_.calc_fscore();
+        }
+        return;
+    }
 
-            openSet.push(child);
+    batch_.resize(children_.size());
+    for (std::size_t i = 0; i < children_.size(); i++)
+    {
+        batch_.g_score[i] = children_[i]->data_.g_score;
+        heuristic_->components(children_[i]->data_, batch_.total[i], batch_.critical_path[i], batch_.next_step[i]);
+    }
+    scoreBatch(batch_, heuristic_->agents());
+    for (std::size_t i = 0; i < children_.size(); i++)
+    {
+        children_[i]->data_.h_score = batch_.h_score[i];
+        children_[i]->data_.f_score = batch_.f_score[i];
+    }
+}
+
+/* Push the children of the last expansion onto the open-set.
+    Children replaced by a sibling reaching the same state with a lower g_score are dropped.
+**/
+void AStarSearch::pushChildren(IndexedHeap<LessThan> &open_set)
+{
+    if (children_replaced_)
+    {
+        std::size_t kept = 0;
+        for (auto child : children_)
+        {
+            if (transpositions_.find(child) == child)
+                children_[kept++] = child;
         }
+        children_.resize(kept);
     }
-    return current;
-}
\ No newline at end of file
+    open_set.pushAll(children_);
+    statistics_.queued += children_.size();
+}
+
+/* Check the limits of the search. Called once per supernode taken from the open-set.
+    The memory limit is compared with the bytes of the Node and Edge objects inside the arena of the search graph.
+    Heap memory owned by them, e.g. the agent-action lists of the edges, is not counted.
+    @graph: search graph. Its arena is used to measure the memory.
+    \return: true if a limit is reached. The status is set accordingly.
+**/
+bool AStarSearch::limitReached(Graph<> *graph)
+{
+    if (expansion_limit_ > 0 && statistics_.expansions >= expansion_limit_)
+    {
+        stop(SearchStatus::ExpansionLimit);
+        return true;
+    }
+    if (memory_limit_ > 0 && graph->arena() && graph->arena()->used() >= memory_limit_)
+    {
+        stop(SearchStatus::MemoryLimit);
+        return true;
+    }
+    if (time_limit_.count() > 0 && std::chrono::steady_clock::now() >= deadline_)
+    {
+        stop(SearchStatus::TimeLimit);
+        return true;
+    }
+    return false;
+}
+
+/* Remember a supernode taken from the open-set if it is the best partial plan so far.
+    Deeper supernodes have applied more steps. Among the same depth, the lower f_score is preferred.
+**/
+void AStarSearch::recordPartial(Node *node)
+{
+    if (node->data_.depth > best_partial_->data_.depth ||
+        (node->data_.depth == best_partial_->data_.depth && node->data_.f_score < best_partial_->data_.f_score))
+        best_partial_ = node;
+}
+
+/* End the search without a goal.
+    @status: reason.
+    \return: the best partial plan.
+**/
+Node *AStarSearch::stop(SearchStatus status)
+{
+    status_ = status;
+    return best_partial_;
+}
+
+/* Calculate the h_score of a supernode.
+    @node: supernode. The legacy heuristic requires the supernode to be expanded.
+    @expander: expander which resolves the subassemblies for the legacy heuristic.
+**/
+void AStarSearch::calcHScore(Node *node, NodeExpander *expander)
+{
+    if (heuristic_)
+        node->data_.h_score = (*heuristic_)(node->data_);
+    else
+        node->data_.calc_hscore(expander->subassemblies(node));
+}
+
+/* Find the best known supernode representing the same state as a given one.
+    @node: supernode to look up.
+    \return: pointer to the stored supernode, nullptr if the state is unknown.
+**/
+Node *TranspositionTable::find(Node *node) const
+{
+    auto range = table_.equal_range(node->data_.state.hash());
+    for (auto it = range.first; it != range.second; it++)
+    {
+        if (it->second == node || it->second->data_.state == node->data_.state)
+            return it->second;
+    }
+    return nullptr;
+}
+
+/* Insert a supernode into the transposition table.
+    If the state is already known, the supernode with the lower g_score is kept.
+    @node: supernode with a valid g_score.
+    @statistics: counters of the search. Duplicates are counted.
+    @replaced: if given, set to the supernode replaced by @node, nullptr if none was replaced.
+    \return: true if the supernode is the best one for its state, false if it is a duplicate.
+**/
+bool TranspositionTable::insert(Node *node, SearchStatistics &statistics, Node **replaced)
+{
+    if (replaced)
+        *replaced = nullptr;
+
+    std::size_t hash = node->data_.state.hash();
+    auto range = table_.equal_range(hash);
+    for (auto it = range.first; it != range.second; it++)
+    {
+        if (it->second->data_.state != node->data_.state)
+            continue;
+
+        statistics.duplicates++;
+        if (it->second->data_.g_score <= node->data_.g_score)
+            return false;
+
+        if (replaced)
+            *replaced = it->second;
+        it->second = node;
+        return true;
+    }
+
+    table_.insert(std::make_pair(hash, node));
+    return true;
+}
+
+/* Remove all supernodes.
+**/
+void TranspositionTable::clear()
+{
+    table_.clear();
+}
+
+/* Descend from a supernode to a goal by creating only the successor of NodeExpander::expandBest in every step.
+    The plan is found without a search, so it is an upper bound the anytime and the beam search start from.
+    The descent starts at a copy of the supernode, so the successors of the supernode are not changed.
+    The plan is backtracked up to the copy, which has no predecessor.
+    The created supernodes are not expanded and not part of any transposition table.
+    @graph: search graph the supernodes are inserted into.
+    @root: supernode the descent starts at. Its g_score has to be set.
+    @expander: exapnder object used to create the successors.
+    @statistics: counts the created supernodes.
+    \return: the goal with its g_score set. nullptr if no goal was reached.
+**/
+Node *greedyDescent(Graph<> *graph, Node *root, NodeExpander *expander, SearchStatistics &statistics)
+{
+    // Every action is executed once and every interaction leads to an agent which reaches the subassembly.
+    // The limit only guards against inconsistent reachability tables.
+    Node *node = graph->insertNode(root->data_);
+    for (std::size_t step = 0; step < SearchState::capacity && !node->data_.isGoal(); step++)
+    {
+        Node *child = expander->expandBest(node);
+        if (!child)
+            return nullptr;
+        child->data_.g_score = node->data_.g_score + child->predecessors().front()->data_.cost;
+        statistics.generated++;
+        node = child;
+    }
+    return node->data_.isGoal() ? node : nullptr;
+}
+
+/* Get the counters collected during the last search.
+**/
+const SearchStatistics &AStarSearch::statistics() const
+{
+    return statistics_;
+}
+
+/* Get the outcome of the last search.
+**/
+SearchStatus AStarSearch::status() const
+{
+    return status_;
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "astar.hpp"
+#include "heuristic.hpp"
+
+/* Beam search.
+    Searches the supernodes layer by layer, where a layer contains the supernodes reached with the same number of steps.
+    Only the width supernodes with the lowest f_score of each layer are expanded, the others are dropped.
+    The search continues until the beam is empty, children which can not improve the best goal found so far are pruned.
+    The search graph grows by at most width times the branching factor per step. The plan is not optimal in general.
+**/
+class BeamSearch
+{
+public:
+    BeamSearch(config::SearchOptions options = config::SearchOptions(), Heuristic *heuristic = nullptr);
+
+    // Search function
+    Node *search(Graph<> *, Node *, NodeExpander *);
+
+    const SearchStatistics &statistics() const;
+
+private:
+    double calcHScore(Node *) const;
+
+    std::size_t width_;
+    bool seed_incumbent_;
+    Heuristic *heuristic_;
+
+    // States of the supernodes kept in a beam, and of the candidates of the current layer.
+    // Dropped candidates are not recorded, so they do not block other paths to their state.
+    TranspositionTable transpositions_;
+    TranspositionTable layer_;
+    std::vector<Node *> beam_;
+    std::vector<Node *> candidates_;
+
+    SearchStatistics statistics_;
+};
+
+/* Comparator function.
+    Orders the open-set heap of the GreedySearch.
+    Orders elements by ascending h_score, ties by ascending g_score.
+**/
+struct LessHScore
+{
+    bool operator()(const Node *lhs, const Node *rhs) const
+    {
+        if (lhs->data_.h_score != rhs->data_.h_score)
+            return lhs->data_.h_score > rhs->data_.h_score;
+        return lhs->data_.g_score > rhs->data_.g_score;
+    }
+};
+
+/* Greedy best-first search.
+    Always expands the supernode with the lowest h_score and returns the first goal it pops.
+    The g_score only breaks ties. The plan is not optimal in general.
+    The open-set is bounded. Once it holds twice the limit, it is cut to the limit supernodes with the lowest h_score.
+    The dropped supernodes are not searched anymore, so on plateaus and dead ends a goal can be missed.
+**/
+class GreedySearch
+{
+public:
+    GreedySearch(config::SearchOptions options = config::SearchOptions(), Heuristic *heuristic = nullptr);
+
+    // Search function
+    Node *search(Graph<> *, Node *, NodeExpander *);
+
+    const SearchStatistics &statistics() const;
+
+private:
+    void push(Node *);
+
+    Heuristic *heuristic_;
+    std::size_t open_limit_;
+    // Binary heap ordered by LessHScore.
+    std::vector<Node *> open_;
+    TranspositionTable transpositions_;
+    SearchStatistics statistics_;
+};
+
+/* Constructor
+    @options: beam_width: number of supernodes kept per layer. At least one.
+              seed_incumbent: if true, the plan of the greedy descent is the first incumbent.
+                              Children which can not improve it are pruned from the first layer on.
+    @heuristic: admissible heuristic. If nullptr, zero is used and the beam keeps the cheapest supernodes.
+**/
+BeamSearch::BeamSearch(config::SearchOptions options, Heuristic *heuristic)
+{
+    width_ = std::max<std::size_t>(options.beam_width, 1);
+    seed_incumbent_ = options.seed_incumbent;
+    heuristic_ = heuristic;
+}
+
+/* Perform the beam search.
+    @graph: pointer to graph on which the search should be performed.
+    @root: pointer to node at which the search should begin.
+    @exapnder: exapnder object used for node expansion.
+    \return: the cheapest goal found. The root if no goal was found.
+**/
+Node *BeamSearch::search(Graph<> *graph, Node *root, NodeExpander *expander)
+{
+    Node *incumbent = nullptr;
+    transpositions_.clear();
+    statistics_ = SearchStatistics();
+
+    root->data_.g_score = 0;
+    root->data_.h_score = calcHScore(root);
+    root->data_.calc_fscore();
+    transpositions_.insert(root, statistics_);
+    if (root->data_.isGoal())
+        return root;
+    if (seed_incumbent_)
+        incumbent = greedyDescent(graph, root, expander, statistics_);
+
+    beam_.assign(1, root);
+    statistics_.queued++;
+
+    while (!beam_.empty())
+    {
+        candidates_.clear();
+        layer_.clear();
+        for (auto node : beam_)
+        {
+            expander->expandNode(node);
+            node->data_.marked = true;
+            statistics_.expansions++;
+            statistics_.generated += node->numberOfSuccessors();
+
+            for (auto edge : node->successors())
+            {
+                Node *child = edge->getDestination();
+                child->data_.g_score = node->data_.g_score + edge->data_.cost;
+                child->data_.h_score = calcHScore(child);
+                child->data_.calc_fscore();
+
+                if (incumbent && child->data_.f_score >= incumbent->data_.g_score)
+                    continue;
+                Node *known = transpositions_.find(child);
+                if (known && known->data_.g_score <= child->data_.g_score)
+                {
+                    statistics_.duplicates++;
+                    continue;
+                }
+                if (!layer_.insert(child, statistics_))
+                    continue;
+
+                if (child->data_.isGoal())
+                    incumbent = child;
+                else
+                    candidates_.push_back(child);
+            }
+        }
+
+        // Drop candidates replaced by a better supernode for the same state or by a cheaper goal.
+        std::size_t kept = 0;
+        for (auto child : candidates_)
+        {
+            if (layer_.find(child) != child ||
+                (incumbent && child->data_.f_score >= incumbent->data_.g_score))
+                continue;
+            candidates_[kept++] = child;
+        }
+        candidates_.resize(kept);
+        statistics_.peak_open = std::max(statistics_.peak_open, candidates_.size());
+
+        // Keep the best width supernodes for the next layer.
+        if (candidates_.size() > width_)
+        {
+            std::nth_element(candidates_.begin(), candidates_.begin() + width_, candidates_.end(),
+                             [](const Node *lhs, const Node *rhs) { return lhs->data_.f_score < rhs->data_.f_score; });
+            candidates_.resize(width_);
+        }
+        for (auto child : candidates_)
+            transpositions_.insert(child, statistics_);
+        beam_.swap(candidates_);
+        statistics_.queued += beam_.size();
+    }
+
+    return incumbent ? incumbent : root;
+}
+
+/* Calculate the h_score of a supernode which is not expanded yet.
+**/
+double BeamSearch::calcHScore(Node *node) const
+{
+    return heuristic_ ? (*heuristic_)(node->data_) : 0;
+}
+
+/* Get the counters collected during the last search.
+**/
+const SearchStatistics &BeamSearch::statistics() const
+{
+    return statistics_;
+}
+
+/* Constructor
+    @options: greedy_open_limit: number of supernodes the open-set is cut to. At least one.
+    @heuristic: heuristic guiding the search. Required, without it no supernode is preferred.
+**/
+GreedySearch::GreedySearch(config::SearchOptions options, Heuristic *heuristic)
+{
+    heuristic_ = heuristic;
+    open_limit_ = std::max<std::size_t>(options.greedy_open_limit, 1);
+}
+
+/* Perform the greedy best-first search.
+    The graph parameter keeps the interface of the other searches. The supernodes are created by the expander.
+    @root: pointer to node at which the search should begin.
+    @exapnder: exapnder object used for node expansion.
+    \return: the first goal popped. The root if no goal was found.
+**/
+Node *GreedySearch::search(Graph<> *, Node *root, NodeExpander *expander)
+{
+    open_.clear();
+    transpositions_.clear();
+    statistics_ = SearchStatistics();
+
+    root->data_.g_score = 0;
+    root->data_.h_score = (*heuristic_)(root->data_);
+    root->data_.calc_fscore();
+    transpositions_.insert(root, statistics_);
+    push(root);
+
+    while (!open_.empty())
+    {
+        statistics_.peak_open = std::max(statistics_.peak_open, open_.size());
+        std::pop_heap(open_.begin(), open_.end(), LessHScore());
+        Node *current = open_.back();
+        open_.pop_back();
+
+        if (transpositions_.find(current) != current)
+            continue;
+
+        if (current->data_.isGoal())
+            return current;
+
+        expander->expandNode(current);
+        current->data_.marked = true;
+        statistics_.expansions++;
+        statistics_.generated += current->numberOfSuccessors();
+
+        for (auto edge : current->successors())
+        {
+            Node *child = edge->getDestination();
+            child->data_.g_score = current->data_.g_score + edge->data_.cost;
+            if (!transpositions_.insert(child, statistics_))
+                continue;
+
+            child->data_.h_score = (*heuristic_)(child->data_);
+            child->data_.calc_fscore();
+            push(child);
+        }
+    }
+    return root;
+}
+
+/* Insert a supernode into the open-set. Cuts the open-set to the limit once it holds twice as many supernodes,
+    so the cut costs amortized constant time per supernode.
+**/
+void GreedySearch::push(Node *node)
+{
+    open_.push_back(node);
+    std::push_heap(open_.begin(), open_.end(), LessHScore());
+    statistics_.queued++;
+
+    if (open_.size() >= 2 * open_limit_)
+    {
+        // LessHScore orders descending, the best supernodes are the last ones.
+        std::nth_element(open_.begin(), open_.begin() + (open_.size() - open_limit_), open_.end(), LessHScore());
+        open_.erase(open_.begin(), open_.begin() + (open_.size() - open_limit_));
+        std::make_heap(open_.begin(), open_.end(), LessHScore());
+    }
+}
+
+/* Get the counters collected during the last search.
+**/
+const SearchStatistics &GreedySearch::statistics() const
+{
+    return statistics_;
+}
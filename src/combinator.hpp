@@ -1,225 +1,315 @@
 #pragma once
 
 #include <vector>
+#include <array>
 #include <string>
 #include <algorithm>
 #include <numeric>
+#include <stdexcept>
 
 #include "graph.hpp"
+#include "csr_graph.hpp"
+#include "compiled_configuration.hpp"
+
+// Maximum number of agents which can be assigned within one step.
+// Can be raised at compile time for larger cells.
+#ifndef COMBINATOR_MAX_AGENTS
+#define COMBINATOR_MAX_AGENTS 16
+#endif
+
+/* Assignment of agents to actions for one step.
+    Fixed-size, so it can be filled without allocating.
+    The i`th agent executes the i`th action.
+**/
+struct Assignment
+{
+    std::size_t size = 0;
+
+    // Dense ids of the agents inside the config::CompiledConfiguration.
+    std::array<std::size_t, COMBINATOR_MAX_AGENTS> agents;
+
+    // Pointers to the And-Nodes of the actions.
+    std::array<Node *, COMBINATOR_MAX_AGENTS> actions;
+};
 
+/* Enumerates the assignments of agents to actions.
+    The assignments are produced one at a time by next(), without materializing all of them.
+    Every agent subset is combined with every choice of one action per subassembly
+    and every ordered selection of these actions for the agents of the subset.
+    Interchangeable agents (config::CompiledConfiguration::agentClass) lead to the same successors at the same cost.
+    Only one representative assignment is produced for them:
+        an agent subset contains the members of a class with the lowest ids,
+        members of a class are assigned to the subassemblies in ascending order.
+    The representatives are concrete agents, so the plan needs no mapping afterwards.
+**/
 class Combinator
 {
 
 public:
-    Combinator(config::Configuration *);
+    Combinator(config::CompiledConfiguration *, const CsrGraph *);
     ~Combinator();
 
-    std::vector<std::vector<std::tuple<std::string, std::string, Node *>>> *
-    generateAgentActionAssignments(std::vector<Node *> &);
+    // Start the enumeration for the given Or-Nodes.
+    void reset(const std::vector<Node *> &);
+
+    // Obtain the next assignment. Returns false if all assignments were produced.
+    bool next(Assignment &);
+
+    // Number of assignments produced since construction.
+    std::size_t enumerated() const;
 
 private:
-    void printAssignments();
-    void assignAgentsToActions(std::vector<std::string> &, std::vector<std::tuple<std::string, Node *>> &);
-    void generateActionCombinationSets(std::vector<Node *> &);
-    void generateAgentCombinationSets(std::vector<std::string> &, int);
+    void printAssignment(const Assignment &);
 
-    std::unordered_map<std::string, std::vector<std::string>> node_actions_; // First entry denotes node.
-                                                                             // Second entry denotes action.
+    bool nextPermutation();
+    bool nextActionSet();
+    bool nextAgentSet();
+    void initAgentSet();
+    void setAgentSet();
+    bool canonicalPermutation() const;
 
-    std::vector<std::string> temp_nodes;
+    // Actions of the current Or-Nodes. Actions of node i are action_list_[action_offsets_[i] .. action_offsets_[i + 1]].
+    // Defined as class-wide objects to reuse the memory between expansions.
+    std::vector<Node *> action_list_;
+    std::vector<std::size_t> action_offsets_;
 
-    std::vector<std::vector<std::tuple<std::string, std::string, Node *>>> agent_action_assignements_;
+    // Number of Or-Nodes, number of agents in the current subset and largest subset.
+    std::size_t n_nodes_;
+    std::size_t k_;
+    std::size_t max_k_;
+    bool done_;
 
-    // Data Structures needed to calculate the agent combinations
-    // Defines as class-wide objects to facilitate reuse between iterations.
-    std::vector<std::vector<std::string>> temp_agent_combinations_;
-    std::vector<std::string> temp_agent_set_;
+    // Selector of the current agent subset and the ids of its agents.
+    std::vector<bool> agent_selector_;
+    std::vector<std::size_t> agent_set_;
 
-    // Data Structures needed for the Action-Combination Generation.
-    // Defined here to create them once and reuse without repeating allocation.
-    std::vector<std::vector<std::tuple<std::string, Node *>>> temp_action_combinations_;
-    std::vector<std::tuple<std::string, Node *>> temp_action_set_;
+    // Position of the previous agent of the same class inside agent_set_, npos if there is none.
+    std::vector<std::size_t> previous_equivalent_;
 
-    config::Configuration *config_;
+    // Index of the chosen action for every Or-Node.
+    std::vector<std::size_t> action_indices_;
+
+    // Permutation of the Or-Nodes. The first k_ entries are assigned to the agents.
+    std::vector<std::size_t> permutation_;
+
+    config::CompiledConfiguration *config_;
+
+    // Snapshot of the And/Or graph. Used to look up the actions of the Or-Nodes.
+    const CsrGraph *graph_;
+
+    std::size_t enumerated_;
 };
 
-Combinator::Combinator(config::Configuration *config)
+Combinator::Combinator(config::CompiledConfiguration *config, const CsrGraph *graph)
 {
     config_ = config;
+    graph_ = graph;
+    done_ = true;
+    enumerated_ = 0;
+
+    if (config_->numberOfAgents() > COMBINATOR_MAX_AGENTS)
+    {
+        std::cerr << "Combinator: " << config_->numberOfAgents() << " agents provided. "
+                  << "Only " << COMBINATOR_MAX_AGENTS << " are supported. "
+                  << "Increase COMBINATOR_MAX_AGENTS." << std::endl;
+        throw std::range_error("Too many agents.");
+    }
 }
 
 Combinator::~Combinator() {}
 
-/* Function which performs the generation of assignments of workers to actions.
+/* Start the enumeration of the assignments of agents to the actions of the given nodes.
+    @nodes: Or-Nodes which still have actions to execute.
 **/
-std::vector<std::vector<std::tuple<std::string, std::string, Node *>>> *
-Combinator::generateAgentActionAssignments(std::vector<Node *> &nodes)
+void Combinator::reset(const std::vector<Node *> &nodes)
 {
+    n_nodes_ = nodes.size();
 
-    std::size_t l = std::min(nodes.size(), config_->agents.size());
-
-    generateActionCombinationSets(nodes);
-
-    agent_action_assignements_.clear();
-
-    std::vector<std::string> vector_of_agents;
-    for (auto &key_value : config_->agents){
-        vector_of_agents.push_back(key_value.second.name);
-    }
-    
-
-    for (size_t j = 1; j <= l; j++)
+    action_list_.clear();
+    action_offsets_.clear();
+    for (auto node : nodes)
     {
-        // std::cout << "Brun" << std::endl;
-
-        generateAgentCombinationSets(vector_of_agents, j);
-
-        for (auto &agents : temp_agent_combinations_)
+        action_offsets_.push_back(action_list_.size());
+        if (graph_->contains(node))
         {
-            for (auto &actions : temp_action_combinations_)
-            {
-                assignAgentsToActions(agents, actions);
-            }
+            for (auto action : graph_->successors(node->id_))
+                action_list_.push_back(graph_->node(action));
+        }
+        else
+        {
+            // Interaction subassemblies are not part of the snapshot.
+            for (auto action : node->successorNodes())
+                action_list_.push_back(action);
         }
     }
+    action_offsets_.push_back(action_list_.size());
 
-    // printAssignments();
+    action_indices_.assign(n_nodes_, 0);
+    permutation_.resize(n_nodes_);
+    std::iota(permutation_.begin(), permutation_.end(), 0);
 
-    return &agent_action_assignements_;
+    max_k_ = std::min(n_nodes_, config_->numberOfAgents());
+    k_ = 1;
+    done_ = (max_k_ == 0);
+    if (!done_)
+        initAgentSet();
 }
 
-/* Function which performs the generation of assignments of workers to actions.
+/* Produce the next assignment.
+    @assignment: filled with the next assignment.
+    \return: false if all assignments have been produced. @assignment is not modified in this case.
 **/
-void Combinator::assignAgentsToActions(std::vector<std::string> &cur_agents,
-                                       std::vector<std::tuple<std::string, Node *>> &cur_actions)
+bool Combinator::next(Assignment &assignment)
 {
+    if (done_)
+        return false;
+
+    enumerated_++;
+    assignment.size = k_;
+    for (std::size_t i = 0; i < k_; i++)
+    {
+        std::size_t node = permutation_[i];
+        assignment.agents[i] = agent_set_[i];
+        assignment.actions[i] = action_list_[action_offsets_[node] + action_indices_[node]];
+    }
+
+    // Advance to the following assignment.
+    // Order: permutations, action combinations, agent subsets, size of the agent subsets.
+    if (nextPermutation() || nextActionSet() || nextAgentSet())
+        return true;
 
-    int n = cur_actions.size();
-    int k = cur_agents.size();
+    k_++;
+    if (k_ > max_k_)
+        done_ = true;
+    else
+        initAgentSet();
 
-    std::vector<std::tuple<std::string, std::string, Node *>> assignment;
+    return true;
+}
 
-    // Create selector vector
-    std::vector<int> d(n);
-    std::iota(d.begin(), d.end(), 0);
-    // std::cout << "These are the Possible Permutations: " << std::endl;
+inline std::size_t
+Combinator::enumerated() const
+{
+    return enumerated_;
+}
+
+/* Advance to the next ordered selection of k_ out of n_nodes_ Or-Nodes.
+    Selections which only swap the Or-Nodes of interchangeable agents are skipped.
+    \return: false if all selections were visited. The permutation is reset in this case.
+**/
+bool Combinator::nextPermutation()
+{
     do
     {
-        for (int i = 0; i < k; i++)
-        {
-            // std::cout << cur_actions[d[i]] << " ";
-            assignment.push_back(std::make_tuple(cur_agents[i],
-                                                 std::get<0>(cur_actions[d[i]]),
-                                                 std::get<1>(cur_actions[d[i]])));
-        }
-        agent_action_assignements_.push_back(assignment);
-        // std::cout << std::endl;
-        assignment.clear();
-        std::reverse(d.begin() + k, d.end());
-    } while (next_permutation(d.begin(), d.end()));
+        std::reverse(permutation_.begin() + k_, permutation_.end());
+        if (!std::next_permutation(permutation_.begin(), permutation_.end()))
+            return false;
+    } while (!canonicalPermutation());
+    return true;
 }
 
-/* Function which performs the generation of assignments of workers to actions.
+/* Check if the interchangeable agents of the subset are assigned to the Or-Nodes in ascending order.
 **/
-void Combinator::generateAgentCombinationSets(std::vector<std::string> &agents, int k)
+bool Combinator::canonicalPermutation() const
 {
-
-    int n = agents.size();
-    temp_agent_combinations_.clear();
-
-    // Create selector vector
-    std::vector<bool> v(n);
-    std::fill(v.begin(), v.begin() + k, true);
-    do
+    for (std::size_t i = 0; i < k_; i++)
     {
-        temp_agent_set_.clear();
-        for (int i = 0; i < n; ++i)
-        {
-            if (v[i])
-            {
-                // std::cout << agents[i] << " ";
-                temp_agent_set_.push_back(agents[i]);
-            }
-        }
-        temp_agent_combinations_.push_back(temp_agent_set_);
-        // std::cout << "\n";
-    } while (std::prev_permutation(v.begin(), v.end()));
+        std::size_t previous = previous_equivalent_[i];
+        if (previous != static_cast<std::size_t>(-1) && permutation_[previous] > permutation_[i])
+            return false;
+    }
+    return true;
 }
 
-/* Function which performs the generation the possible action combinations
+/* Advance to the next choice of one action per Or-Node.
+    \return: false if all combinations were visited. The choice is reset in this case.
 **/
-void Combinator::generateActionCombinationSets(std::vector<Node *> &nodes)
+bool Combinator::nextActionSet()
 {
+    // find the rightmost node that has more actions left after the current one.
+    int next = n_nodes_ - 1;
+    while (next >= 0 &&
+           (action_offsets_[next] + action_indices_[next] + 1 >= action_offsets_[next + 1]))
+        next--;
 
-    temp_action_combinations_.clear();
+    // for all nodes to the right of this node the current action again points to the first one.
+    for (std::size_t i = next + 1; i < n_nodes_; i++)
+        action_indices_[i] = 0;
 
-    // number of arrays
-    int n = nodes.size();
-    int *indices = new int[n];
+    if (next < 0)
+        return false;
 
-    // initialize with first element's index
-    for (int i = 0; i < n; i++)
-        indices[i] = 0;
+    action_indices_[next]++;
+    return true;
+}
 
-    while (1)
+/* Advance to the next subset of k_ agents.
+    Subsets which use a member of a class while a member with a lower id is left out are skipped.
+    \return: false if all subsets were visited.
+**/
+bool Combinator::nextAgentSet()
+{
+    while (std::prev_permutation(agent_selector_.begin(), agent_selector_.end()))
     {
-        temp_action_set_.clear();
-        // print current combination
-        for (int i = 0; i < n; i++)
+        bool canonical = true;
+        for (std::size_t i = 0; canonical && i < agent_selector_.size(); i++)
         {
-            Node *and_node = nodes[i]->getSuccessorNodes()[indices[i]];
-            temp_action_set_.push_back(std::make_tuple(and_node->data_.name, and_node));
-            // std::cout << temp_action_name << " ";
+            if (!agent_selector_[i])
+                continue;
+            std::size_t agent_class = config_->agentClass(i);
+            for (std::size_t other = agent_class; canonical && other < i; other++)
+            {
+                canonical = agent_selector_[other] || config_->agentClass(other) != agent_class;
+            }
         }
-        temp_action_combinations_.push_back(temp_action_set_);
-        // std::cout << std::endl;
-
-        // find the rightmost array that has more
-        // elements left after the current element
-        // in that array
-        int next = n - 1;
-        while (next >= 0 &&
-               (indices[next] + 1 >= nodes[next]->numberOfSuccessors()))
-            next--;
-
-        // no such array is found so no more
-        // combinations left
-        if (next < 0)
-            break;
-
-        // if found move to next element in that
-        // array
-        indices[next]++;
-
-        // for all arrays to the right of this
-        // array current index again points to
-        // first element
-        for (int i = next + 1; i < n; i++)
-            indices[i] = 0;
-    }
+        if (!canonical)
+            continue;
 
-    delete[] indices;
+        setAgentSet();
+        return true;
+    }
+    return false;
 }
 
-/* Debug functionality. Prints the current state of the assignment vector.
+/* Select the first subset of k_ agents. The agents with the lowest ids form a canonical subset.
 **/
-void Combinator::printAssignments()
+void Combinator::initAgentSet()
 {
+    agent_selector_.assign(config_->numberOfAgents(), false);
+    std::fill(agent_selector_.begin(), agent_selector_.begin() + k_, true);
+    setAgentSet();
+}
 
-    std::cout << std::endl
-              << "***************Print current assignments: ********************" << std::endl;
-
-    for (auto const &assignment : agent_action_assignements_)
+/* Collect the ids of the selected agents and link the members of the same class.
+**/
+void Combinator::setAgentSet()
+{
+    agent_set_.clear();
+    previous_equivalent_.clear();
+    for (std::size_t i = 0; i < agent_selector_.size(); i++)
     {
-        for (auto const &elem : assignment)
+        if (!agent_selector_[i])
+            continue;
+
+        std::size_t previous = static_cast<std::size_t>(-1);
+        for (std::size_t j = 0; j < agent_set_.size(); j++)
         {
-            std::cout << std::get<0>(elem) << " : " << std::get<1>(elem)
-                      // << " : " << std::get<2>(elem)->data_.name
-                      << std::endl;
+            if (config_->agentClass(agent_set_[j]) == config_->agentClass(i))
+                previous = j;
         }
-        std::cout << "----------" << std::endl;
+        agent_set_.push_back(i);
+        previous_equivalent_.push_back(previous);
     }
+}
 
-    std::cout << "**************************************************************" << std::endl
-              << std::endl;
+/* Debug functionality. Prints an assignment.
+**/
+void Combinator::printAssignment(const Assignment &assignment)
+{
+    for (std::size_t i = 0; i < assignment.size; i++)
+    {
+        std::cout << config_->agentName(assignment.agents[i]) << " : "
+                  << assignment.actions[i]->data_.name << std::endl;
+    }
+    std::cout << "----------" << std::endl;
 }
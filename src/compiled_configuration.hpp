@@ -0,0 +1,469 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "graph.hpp"
+#include "containers.hpp"
+
+namespace config{
+
+    /* Compiled view of a Configuration.
+        Agents, actions and subassemblies are interned to dense ids.
+        Costs and reachability are stored in flat tables indexed by these ids,
+        so the search does not need to hash strings.
+        The nodes of the And/Or graph obtain the id of their action/subassembly in NodeData::config_index.
+        Built once after the InputReader has read the input.
+    **/
+    class CompiledConfiguration
+    {
+    public:
+        // Constructor
+        CompiledConfiguration(Configuration *, Graph<> *);
+
+        // Sizes of the tables
+        std::size_t numberOfAgents() const;
+        std::size_t numberOfActions() const;
+        std::size_t numberOfSubassemblies() const;
+
+        // Name <-> id conversion
+        std::size_t agentId(const std::string &) const;
+        std::size_t actionId(const std::string &) const;
+        std::size_t subassemblyId(const std::string &) const;
+        const std::string &agentName(std::size_t) const;
+        const std::string &actionName(std::size_t) const;
+        const std::string &subassemblyName(std::size_t) const;
+
+        // Table access
+        double cost(std::size_t, std::size_t) const;
+        bool reachable(std::size_t, std::size_t) const;
+        std::size_t interaction(std::size_t, std::size_t) const;
+
+        // Agents with identical costs and reachability are interchangeable.
+        // The class of an agent is the lowest id of the agents equivalent to it.
+        std::size_t agentClass(std::size_t) const;
+
+        // Table updates, e.g. if an agent slows down or loses the reach of a part during the execution.
+        void setCost(std::size_t, std::size_t, double);
+        void setReachable(std::size_t, std::size_t, bool, std::size_t = 0);
+
+        // SearchState slots of the subassemblies waiting for an interaction.
+        // Every pair of subassembly and interaction-action obtains its own slot.
+        std::size_t numberOfInteractionSlots() const;
+        std::size_t interactionSlot(std::size_t, std::size_t) const;
+        std::size_t slotSubassembly(std::size_t) const;
+        std::size_t slotInteraction(std::size_t) const;
+
+        // Configuration the tables were compiled from.
+        Configuration *source;
+
+    private:
+        std::size_t internAction(const std::string &);
+        std::size_t internSubassembly(const std::string &);
+        void classifyAgents();
+        void assignInteractionSlots();
+
+        std::vector<std::string> agents_;
+        std::vector<std::string> actions_;
+        std::vector<std::string> subassemblies_;
+
+        std::unordered_map<std::string, std::size_t> agent_ids_;
+        std::unordered_map<std::string, std::size_t> action_ids_;
+        std::unordered_map<std::string, std::size_t> subassembly_ids_;
+
+        // cost_[action * agents + agent]
+        std::vector<double> cost_;
+        // reach_[subassembly * agents + agent]
+        std::vector<char> reach_;
+        // interaction_[subassembly * agents + agent]: id of the interaction-action if not reachable.
+        std::vector<std::size_t> interaction_;
+
+        // Equivalence class of every agent. Updated with the tables.
+        std::vector<std::size_t> agent_classes_;
+
+        // Subassemblies of the Or-Nodes of the graph, in the order of the node ids.
+        std::vector<std::size_t> graph_subassemblies_;
+
+        // Interaction slots. slot_ids_[subassembly * actions + interaction], subassembly and interaction of every slot.
+        std::unordered_map<std::size_t, std::size_t> slot_ids_;
+        std::vector<std::size_t> slot_subassemblies_;
+        std::vector<std::size_t> slot_interactions_;
+    };
+
+    /* Constructor. Compile the configuration.
+        Actions without a cost entry for an agent cost 0, subassemblies without a reach entry
+        are reachable. Nodes of the graph which are not mentioned inside the configuration
+        are interned as well.
+        @config: configuration obtained from the InputReader.
+        @graph: And/Or graph obtained from the InputReader. The config_index of its nodes is set.
+    **/
+    CompiledConfiguration::CompiledConfiguration(Configuration *config, Graph<> *graph)
+    {
+        source = config;
+
+        // Intern names in sorted order. This keeps the ids independent of the hashing of the maps.
+        for (auto &agent : config->agents)
+            agents_.push_back(agent.first);
+        std::sort(agents_.begin(), agents_.end());
+        for (std::size_t i = 0; i < agents_.size(); i++)
+            agent_ids_[agents_[i]] = i;
+
+        std::vector<std::string> names;
+        for (auto &action : config->actions)
+            names.push_back(action.first);
+        std::sort(names.begin(), names.end());
+        for (auto &name : names)
+            internAction(name);
+
+        names.clear();
+        for (auto &subassembly : config->subassemblies)
+            names.push_back(subassembly.first);
+        std::sort(names.begin(), names.end());
+        for (auto &name : names)
+            internSubassembly(name);
+
+        // Graph ids are dense, as the InputReader only inserts nodes.
+        for (std::size_t id = 0; id < graph->numberOfNodes(); id++)
+        {
+            Node *node = graph->getNode(id);
+            if (node->data_.type == NodeType::AND)
+            {
+                node->data_.config_index = internAction(node->data_.name);
+            }
+            else
+            {
+                node->data_.config_index = internSubassembly(node->data_.name);
+                graph_subassemblies_.push_back(node->data_.config_index);
+            }
+        }
+
+        std::size_t n_agents = agents_.size();
+
+        cost_.assign(actions_.size() * n_agents, 0);
+        for (auto &action : config->actions)
+        {
+            std::size_t action_id = action_ids_[action.first];
+            for (auto &cost : action.second.costs)
+            {
+                auto agent = agent_ids_.find(cost.first);
+                if (agent != agent_ids_.end())
+                    cost_[action_id * n_agents + agent->second] = cost.second;
+            }
+        }
+
+        reach_.assign(subassemblies_.size() * n_agents, true);
+        interaction_.assign(subassemblies_.size() * n_agents, 0);
+        for (auto &subassembly : config->subassemblies)
+        {
+            std::size_t subassembly_id = subassembly_ids_[subassembly.first];
+            for (auto &reach : subassembly.second.reachability)
+            {
+                auto agent = agent_ids_.find(reach.first);
+                if (agent == agent_ids_.end() || std::get<0>(reach.second))
+                    continue;
+
+                auto interaction = action_ids_.find(std::get<1>(reach.second));
+                if (interaction == action_ids_.end())
+                {
+                    std::cerr << "Configuration: Interaction " << std::get<1>(reach.second)
+                              << " of subassembly " << subassembly.first << " is not an action." << std::endl;
+                    throw std::runtime_error("Unknown interaction.");
+                }
+                reach_[subassembly_id * n_agents + agent->second] = false;
+                interaction_[subassembly_id * n_agents + agent->second] = interaction->second;
+            }
+        }
+
+        classifyAgents();
+        assignInteractionSlots();
+    }
+
+    /* Hand out the SearchState slots of the interactions, in the order of the Or-Nodes and agents.
+        Pairs which already own a slot keep it, so the states of existing supernodes stay valid.
+        Called by the constructor and after the reachability changed.
+    **/
+    void
+    CompiledConfiguration::assignInteractionSlots()
+    {
+        for (auto subassembly : graph_subassemblies_)
+        {
+            for (std::size_t agent = 0; agent < agents_.size(); agent++)
+            {
+                if (reachable(subassembly, agent))
+                    continue;
+
+                std::size_t key = subassembly * actions_.size() + interaction(subassembly, agent);
+                if (slot_ids_.count(key))
+                    continue;
+
+                if (slot_ids_.size() >= SearchState::capacity)
+                {
+                    std::cerr << "Unable to create interaction " << actions_[interaction(subassembly, agent)]
+                              << " for subassembly " << subassemblies_[subassembly]
+                              << ". SearchState capacity of " << SearchState::capacity << " slots exceeded." << std::endl;
+                    throw std::range_error("Too many interactions.");
+                }
+                slot_ids_[key] = slot_subassemblies_.size();
+                slot_subassemblies_.push_back(subassembly);
+                slot_interactions_.push_back(interaction(subassembly, agent));
+            }
+        }
+    }
+
+    /* Group the agents into classes of interchangeable agents.
+        Two agents are equivalent if they have the same cost for every action, reach the same subassemblies
+        and need the same interactions for the others. Swapping them inside a plan does not change its cost.
+    **/
+    void
+    CompiledConfiguration::classifyAgents()
+    {
+        std::size_t n_agents = agents_.size();
+        agent_classes_.resize(n_agents);
+        for (std::size_t agent = 0; agent < n_agents; agent++)
+        {
+            agent_classes_[agent] = agent;
+            for (std::size_t other = 0; other < agent; other++)
+            {
+                if (agent_classes_[other] != other)
+                    continue;
+
+                bool equivalent = true;
+                for (std::size_t action = 0; equivalent && action < actions_.size(); action++)
+                    equivalent = cost_[action * n_agents + agent] == cost_[action * n_agents + other];
+                for (std::size_t subassembly = 0; equivalent && subassembly < subassemblies_.size(); subassembly++)
+                    equivalent = reach_[subassembly * n_agents + agent] == reach_[subassembly * n_agents + other] &&
+                                 interaction_[subassembly * n_agents + agent] == interaction_[subassembly * n_agents + other];
+                if (equivalent)
+                {
+                    agent_classes_[agent] = other;
+                    break;
+                }
+            }
+        }
+    }
+
+    /* Intern an action name.
+        \return: id of the action.
+    **/
+    inline std::size_t
+    CompiledConfiguration::internAction(const std::string &name)
+    {
+        auto it = action_ids_.find(name);
+        if (it != action_ids_.end())
+            return it->second;
+        action_ids_[name] = actions_.size();
+        actions_.push_back(name);
+        return actions_.size() - 1;
+    }
+
+    /* Intern a subassembly name.
+        \return: id of the subassembly.
+    **/
+    inline std::size_t
+    CompiledConfiguration::internSubassembly(const std::string &name)
+    {
+        auto it = subassembly_ids_.find(name);
+        if (it != subassembly_ids_.end())
+            return it->second;
+        subassembly_ids_[name] = subassemblies_.size();
+        subassemblies_.push_back(name);
+        return subassemblies_.size() - 1;
+    }
+
+    inline std::size_t
+    CompiledConfiguration::numberOfAgents() const
+    {
+        return agents_.size();
+    }
+
+    inline std::size_t
+    CompiledConfiguration::numberOfActions() const
+    {
+        return actions_.size();
+    }
+
+    inline std::size_t
+    CompiledConfiguration::numberOfSubassemblies() const
+    {
+        return subassemblies_.size();
+    }
+
+    /* Obtain the id of an agent.
+        @name: name of the agent.
+        \return: dense id of the agent. Throws if the agent is unknown.
+    **/
+    inline std::size_t
+    CompiledConfiguration::agentId(const std::string &name) const
+    {
+        auto it = agent_ids_.find(name);
+        if (it == agent_ids_.end())
+            throw std::range_error("Unknown agent " + name + ".");
+        return it->second;
+    }
+
+    /* Obtain the id of an action.
+        @name: name of the action.
+        \return: dense id of the action. Throws if the action is unknown.
+    **/
+    inline std::size_t
+    CompiledConfiguration::actionId(const std::string &name) const
+    {
+        auto it = action_ids_.find(name);
+        if (it == action_ids_.end())
+            throw std::range_error("Unknown action " + name + ".");
+        return it->second;
+    }
+
+    /* Obtain the id of a subassembly.
+        @name: name of the subassembly.
+        \return: dense id of the subassembly. Throws if the subassembly is unknown.
+    **/
+    inline std::size_t
+    CompiledConfiguration::subassemblyId(const std::string &name) const
+    {
+        auto it = subassembly_ids_.find(name);
+        if (it == subassembly_ids_.end())
+            throw std::range_error("Unknown subassembly " + name + ".");
+        return it->second;
+    }
+
+    inline const std::string &
+    CompiledConfiguration::agentName(std::size_t agent) const
+    {
+        return agents_[agent];
+    }
+
+    inline const std::string &
+    CompiledConfiguration::actionName(std::size_t action) const
+    {
+        return actions_[action];
+    }
+
+    inline const std::string &
+    CompiledConfiguration::subassemblyName(std::size_t subassembly) const
+    {
+        return subassemblies_[subassembly];
+    }
+
+    /* Cost of an agent executing an action.
+        @action: id of the action.
+        @agent: id of the agent.
+    **/
+    inline double
+    CompiledConfiguration::cost(std::size_t action, std::size_t agent) const
+    {
+        return cost_[action * agents_.size() + agent];
+    }
+
+    /* Check if an agent can reach a subassembly.
+        @subassembly: id of the subassembly.
+        @agent: id of the agent.
+    **/
+    inline bool
+    CompiledConfiguration::reachable(std::size_t subassembly, std::size_t agent) const
+    {
+        return reach_[subassembly * agents_.size() + agent];
+    }
+
+    /* Interaction needed if an agent can not reach a subassembly.
+        @subassembly: id of the subassembly.
+        @agent: id of the agent.
+        \return: id of the interaction-action. Only valid if the subassembly is not reachable.
+    **/
+    inline std::size_t
+    CompiledConfiguration::interaction(std::size_t subassembly, std::size_t agent) const
+    {
+        return interaction_[subassembly * agents_.size() + agent];
+    }
+
+    /* Obtain the equivalence class of an agent.
+        @agent: id of the agent.
+        \return: lowest id of the agents which are interchangeable with @agent.
+    **/
+    inline std::size_t
+    CompiledConfiguration::agentClass(std::size_t agent) const
+    {
+        return agent_classes_[agent];
+    }
+
+    /* Change the cost of an agent executing an action.
+        @action: id of the action.
+        @agent: id of the agent.
+        @cost: new cost.
+    **/
+    inline void
+    CompiledConfiguration::setCost(std::size_t action, std::size_t agent, double cost)
+    {
+        cost_[action * agents_.size() + agent] = cost;
+        classifyAgents();
+    }
+
+    /* Change the reachability of a subassembly for an agent.
+        @subassembly: id of the subassembly.
+        @agent: id of the agent.
+        @reachable: true if the agent can reach the subassembly.
+        @interaction: id of the interaction-action needed if the subassembly is not reachable.
+    **/
+    inline void
+    CompiledConfiguration::setReachable(std::size_t subassembly, std::size_t agent, bool reachable, std::size_t interaction)
+    {
+        if (!reachable && interaction >= actions_.size())
+        {
+            std::cerr << "Configuration: Interaction " << interaction << " of subassembly "
+                      << subassemblies_[subassembly] << " is not an action." << std::endl;
+            throw std::runtime_error("Unknown interaction.");
+        }
+        reach_[subassembly * agents_.size() + agent] = reachable;
+        interaction_[subassembly * agents_.size() + agent] = reachable ? 0 : interaction;
+        classifyAgents();
+        if (!reachable)
+            assignInteractionSlots();
+    }
+
+    inline std::size_t
+    CompiledConfiguration::numberOfInteractionSlots() const
+    {
+        return slot_subassemblies_.size();
+    }
+
+    /* Obtain the SearchState slot of a subassembly waiting for a given interaction.
+        @subassembly: id of the subassembly.
+        @interaction: id of the interaction-action.
+        \return: dense index of the pair. Throws if no agent needs the interaction for the subassembly.
+    **/
+    inline std::size_t
+    CompiledConfiguration::interactionSlot(std::size_t subassembly, std::size_t interaction) const
+    {
+        auto slot = slot_ids_.find(subassembly * actions_.size() + interaction);
+        if (slot == slot_ids_.end())
+        {
+            std::cerr << "No slot for interaction " << actions_[interaction]
+                      << " of subassembly " << subassemblies_[subassembly] << "." << std::endl;
+            throw std::range_error("Unknown interaction.");
+        }
+        return slot->second;
+    }
+
+    /* Subassembly waiting in an interaction slot.
+        @slot: interaction slot.
+        \return: id of the subassembly.
+    **/
+    inline std::size_t
+    CompiledConfiguration::slotSubassembly(std::size_t slot) const
+    {
+        return slot_subassemblies_[slot];
+    }
+
+    /* Interaction-action of an interaction slot.
+        @slot: interaction slot.
+        \return: id of the interaction-action.
+    **/
+    inline std::size_t
+    CompiledConfiguration::slotInteraction(std::size_t slot) const
+    {
+        return slot_interactions_[slot];
+    }
+}
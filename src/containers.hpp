@@ -6,6 +6,7 @@
 #include <set>
 #include <vector>
 #include "node.hpp"
+#include "search_state.hpp"
 #include <unordered_map>
 
 enum class NodeType
@@ -22,7 +23,7 @@ public:
     NodeData() {}
 
     bool isGoal();
-    void calc_hscore();
+    void calc_hscore(const std::vector<Node *> &);
     void calc_fscore();
 
     double cost = 0;
@@ -30,6 +31,9 @@ public:
 
     std::string name = "";
 
+    // Dense id of the action (And-Node) or subassembly (Or-Node) inside the config::CompiledConfiguration.
+    std::size_t config_index = 0;
+
     bool marked = false;
 
     double g_score = 0;
@@ -38,8 +42,18 @@ public:
 
     double minimum_cost_action = MAXFLOAT;
 
-    std::unordered_map<std::string, Node *> subassemblies;
-    std::unordered_map<std::string, Node *> actions;
+    // Number of steps from the root of the search.
+    std::size_t depth = 0;
+
+    // Position inside the open-set heap. Maintained by IndexedHeap.
+    std::size_t heap_index = static_cast<std::size_t>(-1);
+
+    // Number of successors created so far by a partial expansion.
+    std::size_t expanded_successors = 0;
+
+    // Compact state of a supernode. Holds its remaining subassemblies and identifies supernodes
+    // representing the same assembly state. The NodeExpander resolves the subassemblies to nodes.
+    SearchState state;
 };
 
 // typedef std::size_t EdgeData;
@@ -85,5 +99,38 @@ namespace config{
         std::unordered_map<std::string, Action> actions;
         std::unordered_map<std::string, Subassembly> subassemblies;
     };
+
+    // Options of the search. Set from the command line.
+    struct SearchOptions{
+        bool lazy_expansion = false;
+        bool partial_expansion = false;
+        bool legacy_heuristic = false;
+        std::size_t threads = 1;
+        std::size_t expansion_threads = 1;
+
+        // Anytime search (ARA*). Epsilon is the weight of the heuristic, the deadline is given in milliseconds.
+        bool anytime = false;
+        double initial_epsilon = 3.0;
+        double epsilon_step = 0.5;
+        std::size_t deadline = 0;
+
+        // Memory-bounded search (IDA*). Maximum number of supernodes kept in memory, 0 for the unbounded A*.
+        std::size_t node_budget = 0;
+
+        // Non-optimal searches. Beam width 0 disables the beam search.
+        std::size_t beam_width = 0;
+        bool greedy = false;
+        // Maximum number of supernodes in the open-set of the greedy search.
+        std::size_t greedy_open_limit = 10000;
+        // Start the anytime and the beam search with the plan of the greedy descent along the cheapest assignments.
+        bool seed_incumbent = true;
+        // Also run the optimal A* and report the cost gap of the non-optimal plan.
+        bool report_gap = false;
+
+        // Limits of the A* search. 0 for no limit. The memory limit is given in bytes of the search graph arena.
+        std::size_t time_limit = 0;
+        std::size_t expansion_limit = 0;
+        std::size_t memory_limit = 0;
+    };
 }
 
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <stdexcept>
+
+#include "graph.hpp"
+
+/* Contiguous range of node ids. Points into the arrays of a CsrGraph.
+**/
+class IdRange
+{
+public:
+    IdRange(const std::uint32_t *begin, const std::uint32_t *end) : begin_(begin), end_(end) {}
+
+    const std::uint32_t *begin() const { return begin_; }
+    const std::uint32_t *end() const { return end_; }
+
+    std::size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+    std::uint32_t front() const { return *begin_; }
+    std::uint32_t operator[](std::size_t index) const { return begin_[index]; }
+
+private:
+    const std::uint32_t *begin_;
+    const std::uint32_t *end_;
+};
+
+/* Immutable compressed-sparse-row snapshot of the And/Or graph.
+    Built once after the InputReader has read the graph and the CompiledConfiguration has set the config_index.
+    The nodes are addressed by their id. Successors of node i are succ_targets_[succ_offsets_[i] .. succ_offsets_[i + 1]],
+    predecessors are stored in the same way. The names are interned into one string pool.
+    The snapshot keeps the Node pointers, so the search can still refer to the nodes of the graph.
+    Nodes created after the snapshot (interactions) are not contained and have to be traversed through their pointers.
+**/
+class CsrGraph
+{
+public:
+    CsrGraph(Graph<> *);
+
+    std::size_t numberOfNodes() const;
+
+    // Check if a node is part of the snapshot.
+    bool contains(const Node *) const;
+
+    // Node data
+    Node *node(std::size_t) const;
+    NodeType type(std::size_t) const;
+    std::size_t configIndex(std::size_t) const;
+    std::string_view name(std::size_t) const;
+
+    // Adjacency
+    IdRange successors(std::size_t) const;
+    IdRange predecessors(std::size_t) const;
+    bool hasSuccessor(std::size_t) const;
+
+private:
+    std::vector<Node *> nodes_;
+    std::vector<NodeType> types_;
+    std::vector<std::size_t> config_index_;
+
+    std::vector<std::uint32_t> succ_offsets_;
+    std::vector<std::uint32_t> succ_targets_;
+    std::vector<std::uint32_t> pred_offsets_;
+    std::vector<std::uint32_t> pred_targets_;
+
+    // name of node i is name_pool_[name_offsets_[i] .. name_offsets_[i + 1]]
+    std::string name_pool_;
+    std::vector<std::uint32_t> name_offsets_;
+};
+
+/* Constructor. Create the snapshot.
+    @graph: And/Or graph obtained from the InputReader. The node ids have to be dense.
+**/
+CsrGraph::CsrGraph(Graph<> *graph)
+{
+    std::size_t n = graph->numberOfNodes();
+
+    nodes_.reserve(n);
+    types_.reserve(n);
+    config_index_.reserve(n);
+    succ_offsets_.reserve(n + 1);
+    pred_offsets_.reserve(n + 1);
+    name_offsets_.reserve(n + 1);
+
+    for (std::size_t id = 0; id < n; id++)
+    {
+        Node *node = graph->getNode(id);
+        if (node->id_ != id)
+        {
+            std::cerr << "CsrGraph: Node " << node->data_.name << " has id " << node->id_
+                      << " at position " << id << ". Node ids have to be dense." << std::endl;
+            throw std::runtime_error("Graph ids not dense.");
+        }
+
+        nodes_.push_back(node);
+        types_.push_back(node->data_.type);
+        config_index_.push_back(node->data_.config_index);
+
+        name_offsets_.push_back(name_pool_.size());
+        name_pool_ += node->data_.name;
+
+        succ_offsets_.push_back(succ_targets_.size());
+        for (auto successor : node->successorNodes())
+            succ_targets_.push_back(successor->id_);
+
+        pred_offsets_.push_back(pred_targets_.size());
+        for (auto predecessor : node->predecessorNodes())
+            pred_targets_.push_back(predecessor->id_);
+    }
+    name_offsets_.push_back(name_pool_.size());
+    succ_offsets_.push_back(succ_targets_.size());
+    pred_offsets_.push_back(pred_targets_.size());
+}
+
+inline std::size_t
+CsrGraph::numberOfNodes() const
+{
+    return nodes_.size();
+}
+
+/* Check if a node is part of the snapshot.
+    Interactions share the ids of the graph, so the pointer is compared.
+    @node: pointer to the node.
+**/
+inline bool
+CsrGraph::contains(const Node *node) const
+{
+    return node->id_ < nodes_.size() && nodes_[node->id_] == node;
+}
+
+/* Obtain the pointer to a node.
+    @id: id of the node.
+**/
+inline Node *
+CsrGraph::node(std::size_t id) const
+{
+    return nodes_[id];
+}
+
+inline NodeType
+CsrGraph::type(std::size_t id) const
+{
+    return types_[id];
+}
+
+/* Obtain the id of the action/subassembly of a node inside the config::CompiledConfiguration.
+    @id: id of the node.
+**/
+inline std::size_t
+CsrGraph::configIndex(std::size_t id) const
+{
+    return config_index_[id];
+}
+
+/* Obtain the name of a node.
+    @id: id of the node.
+    \return: view into the string pool. Valid as long as the snapshot.
+**/
+inline std::string_view
+CsrGraph::name(std::size_t id) const
+{
+    return std::string_view(name_pool_.data() + name_offsets_[id], name_offsets_[id + 1] - name_offsets_[id]);
+}
+
+/* Obtain the ids of the successors of a node.
+    @id: id of the node.
+**/
+inline IdRange
+CsrGraph::successors(std::size_t id) const
+{
+    return IdRange(succ_targets_.data() + succ_offsets_[id], succ_targets_.data() + succ_offsets_[id + 1]);
+}
+
+/* Obtain the ids of the predecessors of a node.
+    @id: id of the node.
+**/
+inline IdRange
+CsrGraph::predecessors(std::size_t id) const
+{
+    return IdRange(pred_targets_.data() + pred_offsets_[id], pred_targets_.data() + pred_offsets_[id + 1]);
+}
+
+inline bool
+CsrGraph::hasSuccessor(std::size_t id) const
+{
+    return succ_offsets_[id + 1] != succ_offsets_[id];
+}
@@ -52,17 +52,17 @@ void DotWriter::writeNode(Node *node)
 {
     fs << "  " << node->id_ << " -> "
        << "{";
-    std::vector<Node *> temp = node->getSuccessorNodes();
-    for (std::size_t i = 0; i < node->numberOfSuccessors(); i++)
+    const EdgeList &temp = node->successors();
+    for (std::size_t i = 0; i < temp.size(); i++)
     {
-        if (i != node->numberOfSuccessors() - 1)
+        if (i != temp.size() - 1)
         {
-            fs << temp[i]->id_
+            fs << temp[i]->getDestination()->id_
                << ", ";
         }
         else
         {
-            fs << temp[i]->id_;
+            fs << temp[i]->getDestination()->id_;
         }
     }
     fs << "}" << std::endl;
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+#include "edge.hpp"
+
+// Number of edges an EdgeList stores without allocating.
+// The nodes of the And/Or graph have few neighbours, supernodes fall back to the heap.
+#ifndef EDGE_LIST_INLINE_CAPACITY
+#define EDGE_LIST_INLINE_CAPACITY 4
+#endif
+
+/* Adjacency list of a Node.
+    Small vector of edge pointers. The first EDGE_LIST_INLINE_CAPACITY edges are stored inside the
+    object itself, larger lists move to a contiguous heap buffer.
+    Edges are kept in the order of their insertion.
+**/
+class EdgeList
+{
+public:
+    typedef Edge **iterator;
+    typedef Edge *const *const_iterator;
+
+    EdgeList();
+    EdgeList(const EdgeList &);
+    EdgeList &operator=(const EdgeList &);
+    ~EdgeList();
+
+    void push_back(Edge *);
+    void erase(iterator);
+    void clear();
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    Edge *front() const { return data_[0]; }
+    Edge *operator[](std::size_t index) const { return data_[index]; }
+
+private:
+    void grow();
+
+    Edge *inline_[EDGE_LIST_INLINE_CAPACITY];
+    Edge **data_;
+    std::size_t size_;
+    std::size_t capacity_;
+};
+
+/* Range over the nodes at one end of the edges of an EdgeList.
+    Iterating does not allocate. Obtained from Node::successorNodes() and Node::predecessorNodes().
+**/
+class NodeRange
+{
+public:
+    class iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef Node *value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Node *const *pointer;
+        typedef Node *reference;
+
+        iterator(EdgeList::const_iterator edge, bool destination) : edge_(edge), destination_(destination) {}
+
+        Node *operator*() const { return destination_ ? (*edge_)->getDestination() : (*edge_)->getSource(); }
+        iterator &operator++()
+        {
+            ++edge_;
+            return *this;
+        }
+        bool operator==(const iterator &other) const { return edge_ == other.edge_; }
+        bool operator!=(const iterator &other) const { return edge_ != other.edge_; }
+
+    private:
+        EdgeList::const_iterator edge_;
+        bool destination_;
+    };
+
+    NodeRange(const EdgeList &edges, bool destination) : edges_(edges), destination_(destination) {}
+
+    iterator begin() const { return iterator(edges_.begin(), destination_); }
+    iterator end() const { return iterator(edges_.end(), destination_); }
+
+    std::size_t size() const { return edges_.size(); }
+    bool empty() const { return edges_.empty(); }
+    Node *front() const { return *begin(); }
+
+private:
+    const EdgeList &edges_;
+    bool destination_;
+};
+
+/* Constructor. Creates an empty list using the inline storage.
+**/
+inline EdgeList::EdgeList()
+{
+    data_ = inline_;
+    size_ = 0;
+    capacity_ = EDGE_LIST_INLINE_CAPACITY;
+}
+
+/* Copy-Constructor.
+**/
+inline EdgeList::EdgeList(const EdgeList &other)
+    : EdgeList()
+{
+    *this = other;
+}
+
+/* Copy-Assignment.
+**/
+inline EdgeList &
+EdgeList::operator=(const EdgeList &other)
+{
+    if (this == &other)
+        return *this;
+
+    clear();
+    for (auto edge : other)
+        push_back(edge);
+    return *this;
+}
+
+/* Destructor. Frees the heap buffer, if one was allocated.
+**/
+inline EdgeList::~EdgeList()
+{
+    if (data_ != inline_)
+        delete[] data_;
+}
+
+/* Append an edge.
+    @edge: pointer to the edge.
+**/
+inline void
+EdgeList::push_back(Edge *edge)
+{
+    if (size_ == capacity_)
+        grow();
+    data_[size_++] = edge;
+}
+
+/* Remove an edge. The order of the remaining edges is kept.
+    @position: iterator pointing to the edge.
+**/
+inline void
+EdgeList::erase(iterator position)
+{
+    std::copy(position + 1, end(), position);
+    size_--;
+}
+
+/* Remove all edges. The memory is kept.
+**/
+inline void
+EdgeList::clear()
+{
+    size_ = 0;
+}
+
+/* Double the capacity and move the edges into a heap buffer.
+**/
+inline void
+EdgeList::grow()
+{
+    Edge **data = new Edge *[capacity_ * 2];
+    std::memcpy(data, data_, size_ * sizeof(Edge *));
+    if (data_ != inline_)
+        delete[] data_;
+    data_ = data;
+    capacity_ *= 2;
+}
@@ -2,10 +2,35 @@
 
 #include <vector>
 #include <set>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
 
 #include "combinator.hpp"
 #include "graph.hpp"
+#include "thread_pool.hpp"
+#include "assignment_solver.hpp"
 
+// Minimum number of assignments of a supernode before its expansion is split over the thread pool.
+#ifndef EXPANDER_PARALLEL_THRESHOLD
+#define EXPANDER_PARALLEL_THRESHOLD 64
+#endif
+
+
+/* Counters of a NodeExpander.
+**/
+struct ExpansionStatistics
+{
+    // Number of agent-action assignments enumerated by the Combinator.
+    std::size_t assignments = 0;
+    // Number of distinct interactions created for subassemblies an agent can not reach.
+    std::size_t interactions = 0;
+    // Number of times an existing interaction was used for a supernode instead of creating a new one.
+    std::size_t interactions_reused = 0;
+    // Number of assignments discarded by the dominance pruning before their successor was created.
+    std::size_t pruned = 0;
+};
 
 /* Class representing the node-expander.
     During the A* search the supernodes need to be expanded.
@@ -19,41 +44,115 @@ class NodeExpander
 
 public:
     // Constructr / Destructor
-    NodeExpander(Graph<> *, config::Configuration *);
+    NodeExpander(Graph<> *, config::CompiledConfiguration *, const CsrGraph *);
     ~NodeExpander();
 
     // Node Expansion function.
     // Called by the A*-search on evary iteration.
     void expandNode(Node *);
 
+    // Partial Node Expansion. Creates the successors in ascending order of their edge cost.
+    double expandNodePartial(Node *, double, std::vector<Node *> &);
+
+    // Create only the successor of the cheapest assignment which keeps as many agents busy as possible.
+    Node *expandBest(Node *);
+
+    // Split the successor construction of wide supernodes over a thread pool. nullptr disables it.
+    void setThreadPool(ThreadPool *);
+
+    // Counters collected since construction.
+    ExpansionStatistics statistics() const;
+
+    // Subassemblies of a supernode, resolved from its SearchState. Valid until the next call.
+    const std::vector<Node *> &subassemblies(Node *);
+
+    // Discard assignments leading to the same successor state as a cheaper one. Enabled by default.
+    void setDominancePruning(bool);
+
 private:
 
+    void startEnumeration(Node *);
+    void collectAssignments(Node *);
+    void pruneDominated(Node *);
+    SearchState successorState(Node *, const Assignment &) const;
+    Node *createSuccessor(Node *, const Assignment &);
+    void buildSuccessor(Node *, const Assignment &, NodeData &, EdgeData &, double &);
+    Node *insertSuccessor(Node *, const NodeData &, const EdgeData &);
+    void expandNodeParallel(Node *);
+
     // Function used to create Interactions if subassemblies are not reachable.
-    Node *createInteraction(Node *, std::string, double);
+    Node *createInteraction(std::size_t);
 
     // Pointer to the graph of HyperNodes on which the A* search runs.
     Graph<> *search_graph_;
 
-    // Pointers to cost/reach maps provided by the InputReader.
-    config::Configuration * config;
+    // Pointers to the cost/reach tables compiled from the InputReader configuration.
+    config::CompiledConfiguration * config;
+
+    // Snapshot of the original And/Or graph.
+    const CsrGraph *original_;
 
-    // Assgnemtn generation object and assignemnt container
+    // Assgnemtn generation object and the assignment currently processed.
     Combinator *assignment_generator;
-    std::vector<std::vector<std::tuple<std::string, std::string, Node *>>> *assignments_;
+    Assignment assignment_;
+
+    // All subassemblies and the ones which still have actions of the expanded supernode.
+    // Defined as class-wide object to reuse the memory between expansions.
+    std::vector<Node *> subassemblies_;
+    std::vector<Node *> open_subassemblies_;
+
+    // Id of the Or-Node of every subassembly of the configuration.
+    std::vector<std::size_t> subassembly_nodes_;
+
+    // Edge cost and enumeration ordinal of the successors during a partial expansion.
+    std::vector<std::pair<double, std::size_t>> ranked_successors_;
+    std::vector<bool> selected_successors_;
 
     // Vectors used to hold references to the created interactions.
     // Needed to perform memory cleanup, as interactions are allocated in expander.
     std::vector<Node *> interaction_nodes;
     std::vector<Edge *> interaction_edges;
+
+    // Interaction subassembly of every slot, nullptr until it is needed first.
+    std::vector<Node *> interactions_;
+    std::size_t interactions_reused_ = 0;
+
+    // Dominance pruning. Successor state and edge cost of every kept assignment, indexed by the hash of the state.
+    bool dominance_pruning_ = true;
+    std::vector<SearchState> kept_states_;
+    std::vector<double> kept_costs_;
+    std::unordered_multimap<std::size_t, std::size_t> kept_index_;
+    std::size_t pruned_ = 0;
+
+    // Optional thread pool and the buffers of a parallel expansion.
+    // The successors are built into slots indexed by the assignment and inserted in enumeration order afterwards.
+    ThreadPool *thread_pool_ = nullptr;
+    std::vector<Assignment> assignments_;
+    std::vector<std::pair<NodeData, EdgeData>> successors_;
+    std::vector<double> min_costs_;
+
+    // Buffers of expandBest. Cost matrix of the open subassemblies and agents,
+    // the cheapest action of every entry and the matching.
+    std::vector<double> best_costs_;
+    std::vector<Node *> best_actions_;
+    AssignmentSolver solver_;
 };
 
 /* NodeExpander Constructor.
 **/
-NodeExpander::NodeExpander(Graph<> *graph, config::Configuration * conf)
+NodeExpander::NodeExpander(Graph<> *graph, config::CompiledConfiguration * conf, const CsrGraph *original)
 {
     search_graph_ = graph;
     config = conf;
-    assignment_generator = new Combinator(config);
+    original_ = original;
+    assignment_generator = new Combinator(config, original_);
+
+    subassembly_nodes_.assign(config->numberOfSubassemblies(), 0);
+    for (std::size_t id = 0; id < original_->numberOfNodes(); id++)
+    {
+        if (original_->type(id) == NodeType::OR)
+            subassembly_nodes_[original_->configIndex(id)] = id;
+    }
 }
 
 /* NodeExpander Destructor.
@@ -72,126 +171,526 @@ NodeExpander::~NodeExpander()
     }
 }
 
+/* Resolve the subassemblies of a supernode from its SearchState.
+    Present subassemblies are the Or-Nodes of the original graph, subassemblies waiting for an interaction
+    are represented by the interaction subassembly of their slot.
+    @node: supernode.
+    \return: subassemblies in the order of their ids, followed by the interactions in the order of their slots.
+**/
+const std::vector<Node *> &NodeExpander::subassemblies(Node *node)
+{
+    subassemblies_.clear();
+    node->data_.state.forEachSubassembly([this](std::size_t id) { subassemblies_.push_back(original_->node(id)); });
+    node->data_.state.forEachInteraction([this](std::size_t slot) { subassemblies_.push_back(createInteraction(slot)); });
+    return subassemblies_;
+}
+
 /* Function which performs the node expansion.
+    Creates a successor supernode for every assignment of agents to actions which is not dominated.
 **/
 void NodeExpander::expandNode(Node *node)
 {
-
-    std::vector<Node *> nodes;
-    nodes.reserve(node->data_.subassemblies.size());
-    for (auto nd : node->data_.subassemblies)
+    if (thread_pool_ && thread_pool_->size() > 1)
     {
-        // std::cout << "Current subass:  " << nd.second->data_.name;
-        if (nd.second->hasSuccessor())
-            nodes.push_back(nd.second);
+        expandNodeParallel(node);
+        return;
     }
 
-    // Obtain all possible assignement cominations of agents to actions for the current step.
-    // The assignment combinations are generated by the Combinator Object.
-    assignments_ = assignment_generator->generateAgentActionAssignments(nodes);
-
-    // Declare the min/ma cost which needs to be set below.
-    double min_action_agent_cost_ = node->data_.minimum_cost_action;
-    double max_action_agent_cost_ = 0;
+    startEnumeration(node);
 
     // Iterate through all possible assignments of agents to available actions.
-    for (auto &cur_assignments : *assignments_)
+    if (!dominance_pruning_)
     {
+        while (assignment_generator->next(assignment_))
+        {
+            createSuccessor(node, assignment_);
+        }
+        return;
+    }
 
-        // Create the data for the created supernode.
-        NodeData ndata;
-        ndata.subassemblies = node->data_.subassemblies;
-        ndata.actions = node->data_.actions;
-        ndata.marked = false;
+    collectAssignments(node);
+    for (auto &assignment : assignments_)
+    {
+        createSuccessor(node, assignment);
+    }
+}
 
-        // Create the data for the edge connecting the current sueprnode with the new one.
-        EdgeData edata;
-        edata.cost = 0;
+/* Node expansion split over the thread pool.
+    The assignments are enumerated first. If there are enough of them, the successors are built by the threads
+    of the pool and inserted into the search graph in the order of the enumeration afterwards,
+    so the search graph is the same as for the sequential expansion.
+    @node: supernode to expand.
+**/
+void NodeExpander::expandNodeParallel(Node *node)
+{
+    startEnumeration(node);
+    collectAssignments(node);
 
-        // Counter variable. Needed to calculate the average cost for the connecting edge.
-        int iters = 0;
+    if (assignments_.size() < EXPANDER_PARALLEL_THRESHOLD)
+    {
+        for (auto &assignment : assignments_)
+            createSuccessor(node, assignment);
+        return;
+    }
 
-        // Iterate through agent-action pairs for the current assignemnt
-        for (auto &agent_action_assignment : cur_assignments)
-        {
-            // Calculate the number of iterations 
-            iters++; 
-
-            // Obtain the agent, action and aciton-pointer from the tuple
-            // The tuple itself was obtained from the combinator above.
-            std::string agent = std::get<0>(agent_action_assignment);
-            std::string action = std::get<1>(agent_action_assignment);
-            Node *action_ptr = std::get<2>(agent_action_assignment);
-
-            // Update the data for the newly-created sueprnode.
-            // The subassebmlies/actions have been copied from the current source node.
-            // Delete the subassemblies/actions which are applied in the current step,
-            // In this way, they are not available in the newly-created node.
-            std::string action_source = action_ptr->getPredecessorNodes().front()->data_.name;
-            ndata.name += action_source + "-" + action + "-" + agent + "     ";
-            ndata.subassemblies.erase(action_source);
-            ndata.actions.erase(action);
-
-            // For the currently applied assignement, update the subassemblies of the new supernode.
-            for (auto &or_successor : action_ptr->getSuccessorNodes())
-            {
-                bool part_reachable = std::get<0>(config->subassemblies[or_successor->data_.name].reachability[agent]);
+    if (successors_.size() < assignments_.size())
+        successors_.resize(assignments_.size());
+    min_costs_.assign(thread_pool_->size(), node->data_.minimum_cost_action);
+
+    // Several chunks per thread, so threads finishing early can steal work.
+    std::size_t grain = std::max<std::size_t>(assignments_.size() / (thread_pool_->size() * 8), 1);
+    thread_pool_->parallelFor(assignments_.size(), grain,
+                              [this, node](std::size_t begin, std::size_t end, std::size_t thread) {
+                                  for (std::size_t i = begin; i < end; i++)
+                                  {
+                                      buildSuccessor(node, assignments_[i], successors_[i].first,
+                                                     successors_[i].second, min_costs_[thread]);
+                                  }
+                              });
+
+    for (std::size_t i = 0; i < assignments_.size(); i++)
+    {
+        insertSuccessor(node, successors_[i].first, successors_[i].second);
+    }
+    for (auto min_cost : min_costs_)
+    {
+        node->data_.minimum_cost_action = std::min(node->data_.minimum_cost_action, min_cost);
+    }
+}
 
-                Node *successor;
+/* Create the successor of the cheapest assignment which uses min(subassemblies, agents) actions.
+    Every agent is matched with at most one open subassembly and executes its cheapest action of it.
+    The matching minimizes the summed cost (AssignmentSolver), so it is the cheapest step among the widest ones.
+    An interaction is only matched with agents which reach its subassembly, otherwise it would be
+    replaced by the next interaction. Pairs which need such an agent are dropped from the assignment.
+    Used to descend to a first plan without enumerating the assignments. The Combinator is not used,
+    the assignment may differ from its representative of interchangeable agents.
+    @node: supernode. Its other successors are not created.
+    \return: the created supernode. nullptr if the supernode has no open subassembly or no agent reaches its interactions.
+**/
+Node *NodeExpander::expandBest(Node *node)
+{
+    std::size_t agents = config->numberOfAgents();
+    open_subassemblies_.clear();
+    for (auto subassembly : subassemblies(node))
+    {
+        if (subassembly->hasSuccessor())
+            open_subassemblies_.push_back(subassembly);
+    }
+    if (open_subassemblies_.empty() || agents == 0)
+        return nullptr;
 
-                if (!part_reachable)
-                {
-                    // Part not reachable
-                    // Add Interaction
-                    std::string interaction_name = std::get<1>(config->subassemblies[or_successor->data_.name].reachability[agent]);
-                    double interaction_cost = config->actions[interaction_name].costs[agent];
-                    successor = createInteraction(or_successor, interaction_name, interaction_cost); // interaction inserted
-                }
-                else
+    best_costs_.assign(open_subassemblies_.size() * agents, INFINITY);
+    best_actions_.assign(open_subassemblies_.size() * agents, nullptr);
+    double highest = 0;
+    for (std::size_t row = 0; row < open_subassemblies_.size(); row++)
+    {
+        Node *subassembly = open_subassemblies_[row];
+        auto consider = [&](Node *action, std::size_t reached) {
+            for (std::size_t agent = 0; agent < agents; agent++)
+            {
+                if (reached != AssignmentSolver::npos && !config->reachable(reached, agent))
+                    continue;
+                double cost = config->cost(action->data_.config_index, agent);
+                highest = std::max(highest, cost);
+                if (cost < best_costs_[row * agents + agent])
                 {
-                    successor = or_successor; // No interaction inserted. Just append the orsuccesor
+                    best_costs_[row * agents + agent] = cost;
+                    best_actions_[row * agents + agent] = action;
                 }
+            }
+        };
 
-                ndata.subassemblies[or_successor->data_.name] = successor;
-                for (auto &following_action : or_successor->getSuccessorNodes())
-                {
-                    ndata.actions[following_action->data_.name] = following_action;
-                }
+        // Interaction subassemblies are not part of the snapshot.
+        if (original_->contains(subassembly))
+        {
+            for (auto action : original_->successors(subassembly->id_))
+                consider(original_->node(action), AssignmentSolver::npos);
+        }
+        else
+        {
+            for (auto action : subassembly->successorNodes())
+                consider(action, subassembly->data_.config_index);
+        }
+    }
+
+    // The solver needs finite costs. Excluded pairs cost more than any matching without them.
+    double excluded = (highest + 1) * (open_subassemblies_.size() + 1);
+    for (auto &cost : best_costs_)
+    {
+        if (cost == INFINITY)
+            cost = excluded;
+    }
+
+    solver_.solve(best_costs_.data(), open_subassemblies_.size(), agents);
+
+    Assignment assignment;
+    for (std::size_t row = 0; row < open_subassemblies_.size(); row++)
+    {
+        std::size_t agent = solver_.column(row);
+        if (agent == AssignmentSolver::npos || !best_actions_[row * agents + agent])
+            continue;
+        assignment.agents[assignment.size] = agent;
+        assignment.actions[assignment.size] = best_actions_[row * agents + agent];
+        assignment.size++;
+    }
+    if (assignment.size == 0)
+        return nullptr;
+    return createSuccessor(node, assignment);
+}
+
+/* Enumerate all assignments of the supernode into assignments_ and discard the dominated ones.
+    startEnumeration has to be called before.
+    @node: supernode to expand.
+**/
+void NodeExpander::collectAssignments(Node *node)
+{
+    assignments_.clear();
+    while (assignment_generator->next(assignment_))
+    {
+        assignments_.push_back(assignment_);
+    }
+    if (dominance_pruning_)
+        pruneDominated(node);
+}
+
+/* Discard the assignments of assignments_ which are dominated.
+    An assignment is dominated if another one leads to the same successor state with a lower or equal edge cost.
+    This happens if the same actions are executed by different agents which reach the same parts.
+    The remaining cost only depends on the successor state, so an optimal plan is kept.
+    Leaving an agent idle or choosing an interaction is not dominated in general, as the edge cost is
+    the average over the actions of the step. Such assignments are kept.
+    The first of several equally cheap assignments is kept, the order of the kept assignments is preserved.
+    @node: supernode to expand. Its minimum_cost_action covers the discarded assignments as well.
+**/
+void NodeExpander::pruneDominated(Node *node)
+{
+    kept_states_.clear();
+    kept_costs_.clear();
+    kept_index_.clear();
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < assignments_.size(); i++)
+    {
+        const Assignment &assignment = assignments_[i];
+        double cost = 0;
+        for (std::size_t j = 0; j < assignment.size; j++)
+        {
+            double action_cost = config->cost(assignment.actions[j]->data_.config_index, assignment.agents[j]);
+            node->data_.minimum_cost_action = std::min(node->data_.minimum_cost_action, action_cost);
+            cost += action_cost;
+        }
+        cost /= assignment.size;
+
+        SearchState state = successorState(node, assignment);
+        std::size_t hash = state.hash();
+        bool dominated = false;
+        auto range = kept_index_.equal_range(hash);
+        for (auto it = range.first; it != range.second; it++)
+        {
+            std::size_t other = it->second;
+            if (kept_states_[other] != state)
+                continue;
+
+            dominated = true;
+            if (cost < kept_costs_[other])
+            {
+                assignments_[other] = assignment;
+                kept_costs_[other] = cost;
             }
+            break;
+        }
+        if (dominated)
+        {
+            pruned_++;
+            continue;
+        }
 
-            // Update the minimum cost which can be achieved by any agent for any available action.
-            if (config->actions[action].costs[agent] < min_action_agent_cost_)
+        kept_index_.insert(std::make_pair(hash, kept));
+        kept_states_.push_back(state);
+        kept_costs_.push_back(cost);
+        assignments_[kept++] = assignment;
+    }
+    assignments_.resize(kept);
+}
+
+/* Enable or disable the dominance pruning.
+    Searches which update the edge costs of existing supernodes need all successors and disable it.
+**/
+void NodeExpander::setDominancePruning(bool enabled)
+{
+    dominance_pruning_ = enabled;
+}
+
+/* Get the counters collected since the construction of the expander.
+**/
+ExpansionStatistics NodeExpander::statistics() const
+{
+    ExpansionStatistics statistics;
+    statistics.assignments = assignment_generator->enumerated();
+    // Every interaction consists of the interaction subassembly and the interaction-action.
+    statistics.interactions = interaction_nodes.size() / 2;
+    statistics.interactions_reused = interactions_reused_;
+    statistics.pruned = pruned_;
+    return statistics;
+}
+
+/* Set the thread pool used to expand wide supernodes.
+    @pool: thread pool. Has to outlive the expander. nullptr for sequential expansion.
+**/
+void NodeExpander::setThreadPool(ThreadPool *pool)
+{
+    thread_pool_ = pool;
+}
+
+/* Function which performs a partial node expansion.
+    The successors are ranked by the cost of their connecting edge.
+    Only successors with a cost up to @cost_bound are created, in ascending order of the cost.
+    The cheapest remaining successor is always created. Successors created by earlier calls are not created again.
+    @node: supernode to expand.
+    @cost_bound: maximum cost of the edges to the created successors.
+    @created: the created successors are appended.
+    \return: cost of the cheapest successor which has not been created, INFINITY if there is none.
+**/
+double NodeExpander::expandNodePartial(Node *node, double cost_bound, std::vector<Node *> &created)
+{
+    // Rank all assignments by the cost of the edge they would create.
+    startEnumeration(node);
+    ranked_successors_.clear();
+    std::size_t ordinal = 0;
+    while (assignment_generator->next(assignment_))
+    {
+        double cost = 0;
+        for (std::size_t i = 0; i < assignment_.size; i++)
+        {
+            double action_cost = config->cost(assignment_.actions[i]->data_.config_index, assignment_.agents[i]);
+            if (action_cost < node->data_.minimum_cost_action)
             {
-                min_action_agent_cost_ = config->actions[action].costs[agent];
+                node->data_.minimum_cost_action = action_cost;
             }
+            cost += action_cost;
+        }
+        ranked_successors_.push_back(std::make_pair(cost / assignment_.size, ordinal++));
+    }
+    std::sort(ranked_successors_.begin(), ranked_successors_.end());
+
+    // At least one successor is created, so the f_score derived from the returned cost always makes progress.
+    // (g_score + cost - g_score may be rounded below cost).
+    std::size_t first = node->data_.expanded_successors;
+    std::size_t last = first;
+    while (last < ranked_successors_.size() &&
+           (last == first || ranked_successors_[last].first <= cost_bound))
+    {
+        last++;
+    }
+
+    // The enumeration order is deterministic. Enumerate again and create the selected successors.
+    if (last > first)
+    {
+        selected_successors_.assign(ranked_successors_.size(), false);
+        for (std::size_t i = first; i < last; i++)
+        {
+            selected_successors_[ranked_successors_[i].second] = true;
+        }
+
+        startEnumeration(node);
+        ordinal = 0;
+        while (assignment_generator->next(assignment_))
+        {
+            if (selected_successors_[ordinal++])
+                created.push_back(createSuccessor(node, assignment_));
+        }
+        node->data_.expanded_successors = last;
+    }
+
+    if (last < ranked_successors_.size())
+        return ranked_successors_[last].first;
+    return INFINITY;
+}
+
+/* Start the enumeration of the assignments for a given supernode.
+    @node: supernode to expand.
+**/
+void NodeExpander::startEnumeration(Node *node)
+{
+    open_subassemblies_.clear();
+    for (auto subassembly : subassemblies(node))
+    {
+        if (subassembly->hasSuccessor())
+            open_subassemblies_.push_back(subassembly);
+    }
+
+    // Enumerate all possible assignement cominations of agents to actions for the current step.
+    // The assignment combinations are generated one by one by the Combinator Object.
+    assignment_generator->reset(open_subassemblies_);
+}
 
-            // Update edge data.
-            edata.cost += config->actions[action].costs[agent];
-            edata.agent_actions_.push_back(std::make_pair(action_ptr, agent));
+/* Create the successor supernode for a given assignment and insert it into the search graph.
+    Updates the minimum agent-action cost of the expanded supernode.
+    @node: supernode which is expanded.
+    @assignment: assignment of agents to actions applied in the step.
+    \return: the created supernode.
+**/
+Node *NodeExpander::createSuccessor(Node *node, const Assignment &assignment)
+{
+    NodeData ndata;
+    EdgeData edata;
+    buildSuccessor(node, assignment, ndata, edata, node->data_.minimum_cost_action);
+    return insertSuccessor(node, ndata, edata);
+}
+
+/* Build the data of the successor supernode for a given assignment.
+    Does not modify the expander or the search graph. The subassemblies of the successor are only stored
+    inside its SearchState, interactions are created when it is expanded.
+    Can be called from several threads at once.
+    @node: supernode which is expanded.
+    @assignment: assignment of agents to actions applied in the step.
+    @ndata: filled with the data of the successor.
+    @edata: filled with the data of the connecting edge.
+    @min_cost: lowered to the minimum agent-action cost of the assignment.
+**/
+void NodeExpander::buildSuccessor(Node *node, const Assignment &assignment,
+                                  NodeData &ndata, EdgeData &edata, double &min_cost)
+{
+    // Create the data for the created supernode.
+    ndata = NodeData();
+    ndata.state = successorState(node, assignment);
+    ndata.marked = false;
+    ndata.depth = node->data_.depth + 1;
+
+    // Create the data for the edge connecting the current sueprnode with the new one.
+    edata = EdgeData();
+    edata.cost = 0;
+    edata.agent_actions_.reserve(assignment.size);
+
+    // Counter variable. Needed to calculate the average cost for the connecting edge.
+    int iters = 0;
+
+    // Iterate through agent-action pairs for the current assignemnt
+    for (std::size_t i = 0; i < assignment.size; i++)
+    {
+        // Calculate the number of iterations 
+        iters++; 
+
+        // Obtain the agent and aciton-pointer from the assignment.
+        // The assignment itself was obtained from the combinator above.
+        std::size_t agent_id = assignment.agents[i];
+        Node *action_ptr = assignment.actions[i];
+        const std::string &agent = config->agentName(agent_id);
+        double action_cost = config->cost(action_ptr->data_.config_index, agent_id);
+
+        // Update the minimum cost which can be achieved by any agent for any available action.
+        // It is needed for the heuristic used by the A* algorithm.
+        if (action_cost < min_cost)
+        {
+            min_cost = action_cost;
         }
 
-        // Create the average of the edge.cost over the number of nodes it connects.
-        // (This edge is a edge connecting supernodes of the search graph).
-        // (That is why the average-step is necessary).
-        edata.cost = edata.cost / iters;
+        // Update edge data.
+        edata.cost += action_cost;
+        edata.agent_actions_.push_back(std::make_pair(action_ptr, agent));
+    }
 
-        // Insert the newly-created sueprnode into the search-graph.
-        Node *next_node = search_graph_->insertNode(ndata);
+    // Create the average of the edge.cost over the number of nodes it connects.
+    // (This edge is a edge connecting supernodes of the search graph).
+    // (That is why the average-step is necessary).
+    edata.cost = edata.cost / iters;
+}
 
-        // Insert the edge connecting the new-sueprnode to the source (old) one.
-        search_graph_->insertEdge(edata, node->id_, next_node->id_);
+/* Compute the SearchState of the successor of a supernode for a given assignment.
+    Does not create interactions, so it can be evaluated for assignments which are discarded afterwards.
+    @node: supernode which is expanded.
+    @assignment: assignment of agents to actions applied in the step.
+    \return: state without the applied subassemblies and actions, with their parts and the pending interactions.
+**/
+SearchState NodeExpander::successorState(Node *node, const Assignment &assignment) const
+{
+    SearchState state = node->data_.state;
+    for (std::size_t i = 0; i < assignment.size; i++)
+    {
+        std::size_t agent_id = assignment.agents[i];
+        Node *action_ptr = assignment.actions[i];
+        bool in_graph = original_->contains(action_ptr);
+
+        // Interaction subassemblies are not part of the original graph. They are tracked by their slot.
+        // An interaction-action leads back to its original subassembly.
+        std::uint32_t interaction_successor = 0;
+        IdRange or_successors(&interaction_successor, &interaction_successor + 1);
+        if (in_graph)
+        {
+            // The alternative actions of the subassembly are not available anymore.
+            std::size_t source = original_->predecessors(action_ptr->id_).front();
+            state.removeSubassembly(source);
+            for (auto alternative : original_->successors(source))
+            {
+                state.removeAction(alternative);
+            }
+            or_successors = original_->successors(action_ptr->id_);
+        }
+        else
+        {
+            Node *source_ptr = action_ptr->predecessors().front()->getSource();
+            state.removeInteraction(config->interactionSlot(source_ptr->data_.config_index, action_ptr->data_.config_index));
+            interaction_successor = action_ptr->successors().front()->getDestination()->id_;
+        }
+
+        // A part which is not reachable waits for its interaction. Its actions become available afterwards.
+        for (auto or_id : or_successors)
+        {
+            std::size_t subassembly_id = original_->configIndex(or_id);
+            if (!config->reachable(subassembly_id, agent_id))
+            {
+                std::size_t interaction = config->interaction(subassembly_id, agent_id);
+                state.addInteraction(config->interactionSlot(subassembly_id, interaction));
+                continue;
+            }
+            state.addSubassembly(or_id);
+            for (auto following_action : original_->successors(or_id))
+            {
+                state.addAction(following_action);
+            }
+        }
     }
+    return state;
+}
+
+/* Insert a successor supernode and its connecting edge into the search graph.
+    @node: supernode which is expanded.
+    @ndata: data of the successor.
+    @edata: data of the connecting edge.
+    \return: the created supernode.
+**/
+Node *NodeExpander::insertSuccessor(Node *node, const NodeData &ndata, const EdgeData &edata)
+{
+    // Insert the newly-created sueprnode into the search-graph.
+    Node *next_node = search_graph_->insertNode(ndata);
+
+    // Insert the edge connecting the new-sueprnode to the source (old) one.
+    // The source may be stored inside the graph of another search worker, so the edge is inserted by pointer.
+    search_graph_->insertEdge(edata, node, next_node);
 
-    // Set the minum-agen-action cost for the curent supernode.
-    // It is needed for the heuristic used by the A* algorithm.
-    node->data_.minimum_cost_action = min_action_agent_cost_;
+    return next_node;
 }
 
 /* Returns interactions for subassemblies (parts).
-    Interactions are created for assignemnts where a given agent cannot reach a part (subassembly).
+    Interactions are needed for assignemnts where a given agent cannot reach a part (subassembly).
+    The interaction subgraph only depends on the subassembly and the interaction-action, not on the agent.
+    It is created once per slot and shared by all supernodes. The cost is taken from the configuration
+    for the agent executing the interaction.
+    @slot: interaction slot of the pair of subassembly and interaction-action.
+    \return: the interaction subassembly.
 **/
-Node *NodeExpander::createInteraction(Node *destination_or, std::string i_name, double i_cost)
+Node *NodeExpander::createInteraction(std::size_t slot)
 {
+    if (slot < interactions_.size() && interactions_[slot])
+    {
+        interactions_reused_++;
+        return interactions_[slot];
+    }
+
+    Node *destination_or = original_->node(subassembly_nodes_[config->slotSubassembly(slot)]);
+    std::size_t interaction = config->slotInteraction(slot);
+
     // Create interaction subassembly. It cotains same data as original one.
     NodeData tdata = destination_or->data_;
     tdata.name = destination_or->data_.name + "_prime";
@@ -200,8 +699,9 @@ Node *NodeExpander::createInteraction(Node *destination_or, std::string i_name,
 
     // Create node for interaction-Action.
     NodeData idata;
-    idata.cost = i_cost;
-    idata.name = i_name;
+    idata.name = config->actionName(interaction);
+    idata.type = NodeType::AND;
+    idata.config_index = interaction;
     Node *inter_action = new Node(0, idata);
     interaction_nodes.push_back(inter_action);
 
@@ -221,6 +721,10 @@ Node *NodeExpander::createInteraction(Node *destination_or, std::string i_name,
     edge2->setDestination(destination_or);
     inter_action->addSuccessor(edge2);
 
+    if (slot >= interactions_.size())
+        interactions_.resize(slot + 1, nullptr);
+    interactions_[slot] = or_prime;
+
     // Return the interaction subassembly to insert into the current supernode.
     return or_prime;
 }
@@ -9,6 +9,7 @@
 #include <memory>
 
 #include "node.hpp"
+#include "arena.hpp"
 #include "visitor.hpp"
 #include "dotwriter.hpp"
 
@@ -19,6 +20,7 @@ public:
     // Construction, Destruction
     Graph(const Visitor & = Visitor());
     Graph(const std::size_t, const std::size_t, const Visitor & = Visitor());
+    Graph(Arena *, const Visitor & = Visitor());
     Graph(const Graph<> &);
     ~Graph();
 
@@ -28,6 +30,9 @@ public:
     std::size_t numberOfEdgesFromNode(const std::size_t);
     std::size_t numberOfEdgesToNode(const std::size_t);
 
+    // Arena holding the nodes and edges. nullptr if they are allocated one by one.
+    const Arena *arena() const;
+
     Node *getNode(std::size_t);
     // std::vector<Node *> getNodes(bool (*)(Node *));
     std::vector<Node *> getLeafNodes();
@@ -45,6 +50,7 @@ public:
     Node *insertNode(const Node &);
     std::size_t insertNodes(const std::vector<Node *> &);
     std::size_t insertEdge(const EdgeData, const std::size_t, const std::size_t);
+    std::size_t insertEdge(const EdgeData, Node *, Node *);
     std::size_t insertEdges(const EdgeData,
                             const std::size_t,
                             const std::vector<std::size_t> &);
@@ -71,6 +77,15 @@ public:
 private:
     std::size_t findEdgeIndexHelper(Edge *);
 
+    // Creation and destruction of nodes/edges. Uses the arena if one is set.
+    Node *createNode(std::size_t, const NodeData &);
+    Edge *createEdge(const EdgeData &);
+    void destroyNode(Node *);
+    void destroyEdge(Edge *);
+
+    // Optional arena for the nodes and edges. Not owned by the graph.
+    Arena *arena_ = nullptr;
+
     std::unordered_map<std::size_t, Node *> nodes_;
     std::size_t free_node_id_;
     std::vector<Edge *> edges_;
@@ -109,6 +124,24 @@ inline Graph<Visitor>::Graph(
     free_node_id_ = 0;
 }
 
+/* Construct a graph which places its nodes and edges inside an arena.
+    The nodes and edges are destroyed together with the graph, their memory is released with the arena.
+    Nodes passed to insertNodes() are destroyed as well, but their memory is not freed.
+    @arena: arena for the nodes and edges. Has to outlive the graph.
+    @visitor: Visitor to follow changes of integer indices of vertices and edges.
+**/
+template <typename Visitor>
+inline Graph<Visitor>::Graph(
+    Arena *arena,
+    const Visitor &visitor)
+    : nodes_(),
+      edges_(),
+      visitor_(visitor)
+{
+    free_node_id_ = 0;
+    arena_ = arena;
+}
+
 /* Copy-Constructor. Clone a given graph.
     @graph: source graph which should be copied. 
             The resulting graph is a clone of the original one. 
@@ -129,15 +162,71 @@ inline Graph<Visitor>::~Graph()
 
     for (auto &node : nodes_)
     {
-        delete node.second;
+        destroyNode(node.second);
     }
 
     for (auto &edge : edges_)
     {
-        delete edge;
+        destroyEdge(edge);
     }
 }
 
+template <typename Visitor>
+inline const Arena *
+Graph<Visitor>::arena() const
+{
+    return arena_;
+}
+
+/* Allocate a node. Placed inside the arena if one is set.
+    @id: id of the node.
+    @data: data of the node.
+**/
+template <typename Visitor>
+inline Node *
+Graph<Visitor>::createNode(std::size_t id, const NodeData &data)
+{
+    if (arena_)
+        return arena_->create<Node>(id, data);
+    return new Node(id, data);
+}
+
+/* Allocate an edge. Placed inside the arena if one is set.
+    @data: data of the edge.
+**/
+template <typename Visitor>
+inline Edge *
+Graph<Visitor>::createEdge(const EdgeData &data)
+{
+    if (arena_)
+        return arena_->create<Edge>(data);
+    return new Edge(data);
+}
+
+/* Destroy a node. The memory of arena nodes is released with the arena.
+**/
+template <typename Visitor>
+inline void
+Graph<Visitor>::destroyNode(Node *node)
+{
+    if (arena_)
+        node->~Node();
+    else
+        delete node;
+}
+
+/* Destroy an edge. The memory of arena edges is released with the arena.
+**/
+template <typename Visitor>
+inline void
+Graph<Visitor>::destroyEdge(Edge *edge)
+{
+    if (arena_)
+        edge->~Edge();
+    else
+        delete edge;
+}
+
 /* Get the number of nodes.
 **/
 template <typename Visitor>
@@ -249,7 +338,13 @@ Graph<Visitor>::edgeFromNode(
                   << "Error: edgeFromNode. Node " << node << " not in graph." << std::endl;
         throw std::range_error("Unable to access node.");
     }
-    return nodes_.at(node)->children_[j];
+    if (j >= nodes_.at(node)->numberOfSuccessors())
+    {
+        std::cerr << std::endl
+                  << "Error: edgeFromNode. Node " << node << " has no edge " << j << "." << std::endl;
+        throw std::range_error("Unable to access edge.");
+    }
+    return nodes_.at(node)->successors()[j];
 }
 
 /* Get the pointer to the j`th edge that is incident to a given node.
@@ -268,7 +363,13 @@ Graph<Visitor>::edgeToNode(
                   << "Error: edgeToNode. Node " << node << " not in graph." << std::endl;
         throw std::range_error("Unable to access node.");
     }
-    return nodes_.at(node)->parents_[j];
+    if (j >= nodes_.at(node)->numberOfPredecessors())
+    {
+        std::cerr << std::endl
+                  << "Error: edgeToNode. Node " << node << " has no edge " << j << "." << std::endl;
+        throw std::range_error("Unable to access edge.");
+    }
+    return nodes_.at(node)->predecessors()[j];
 }
 
 /* Get pointers to the nodes reachable from a given node via a specified edge.
@@ -319,7 +420,7 @@ inline Node *
 Graph<Visitor>::insertNode(const Node &node)
 {
     NodeData ndata = node.data_;
-    Node *tempNode = new Node(free_node_id_, ndata);
+    Node *tempNode = createNode(free_node_id_, ndata);
     nodes_.insert(std::make_pair(free_node_id_, tempNode));
     free_node_id_++;
     // visitor_.insertVertex(nodeId);
@@ -335,7 +436,7 @@ template <typename Visitor>
 inline Node *
 Graph<Visitor>::insertNode(NodeData data)
 {
-    Node *tempNode = new Node(free_node_id_, data);
+    Node *tempNode = createNode(free_node_id_, data);
     nodes_.insert(std::make_pair(free_node_id_, tempNode));
     free_node_id_++;
     // visitor_.insertVertex(nodeId);
@@ -389,7 +490,7 @@ Graph<Visitor>::insertEdge(
         throw std::range_error("Unable to create edge.");
     }
 
-    Edge *edge = new Edge(data);
+    Edge *edge = createEdge(data);
     edge->setDestination(nodes_[destNodeId]);
     edge->setSource(nodes_[srcNodeId]);
     edges_.push_back(edge);
@@ -399,6 +500,30 @@ Graph<Visitor>::insertEdge(
     return edges_.size();
 }
 
+/* Insert additional edge between two given nodes.
+    The nodes are not looked up, they may be stored inside a different graph.
+    The edge is owned by this graph.
+    @source: source node of the edge.
+    @destination: destination node of the edge.
+    \return Integer index of the newly inserted edge.
+**/
+template <typename Visitor>
+std::size_t
+Graph<Visitor>::insertEdge(
+    const EdgeData data,
+    Node *source,
+    Node *destination)
+{
+    Edge *edge = createEdge(data);
+    edge->setDestination(destination);
+    edge->setSource(source);
+    edges_.push_back(edge);
+    source->addSuccessor(edge);
+    destination->addPredecessor(edge);
+
+    return edges_.size();
+}
+
 /* Insert additional edges.
     @srcNodeId: string-ids of the source nodes of the edges.
     @destNodeId: string-ids of the destinaion nodes of the edges.
@@ -486,14 +611,8 @@ Graph<Visitor>::copy(
 
         node = mapping.second;
 
-        for (auto &predecessor_edge : node->getPredecessors())
-        {
-            insertEdge(predecessor_edge->data_,
-                       index_map[predecessor_edge->getSource()->id_],
-                       index_map[node->id_]);
-        }
-
-        for (auto &successor_edge : node->getSuccessors())
+        // Every edge is the successor of exactly one node. Copying the successors copies each edge once.
+        for (auto successor_edge : node->successors())
         {
             insertEdge(successor_edge->data_,
                        index_map[node->id_],
@@ -609,7 +728,7 @@ bool Graph<Visitor>::eraseEdge(
     source_node->removeSuccessor(nodeDst);
     destination_node->removePredecessor(nodeSrc);
 
-    delete edges_[edgeIndex];
+    destroyEdge(edges_[edgeIndex]);
     edges_.erase(edges_.begin() + edgeIndex);
 
     return true;
@@ -647,7 +766,7 @@ bool Graph<Visitor>::eraseNode(
 
         temp_edge_index = findEdgeIndexHelper(edge_to_remove);
         edges_.erase(edges_.begin() + temp_edge_index);
-        delete edge_to_remove;
+        destroyEdge(edge_to_remove);
     }
 
     for (size_t j = 0; j < successors.size(); j++)
@@ -658,10 +777,10 @@ bool Graph<Visitor>::eraseNode(
 
         temp_edge_index = findEdgeIndexHelper(edge_to_remove);
         edges_.erase(edges_.begin() + temp_edge_index);
-        delete edge_to_remove;
+        destroyEdge(edge_to_remove);
     }
 
-    delete node_to_remove;
+    destroyNode(node_to_remove);
 
     return true;
 }
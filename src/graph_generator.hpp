@@ -93,7 +93,7 @@ std::size_t GraphGenerator::insertOr(std::string name)
 {
     NodeData data;
     data.name = name;
-    data.type = NodeType::AND;
+    data.type = NodeType::OR;
     data.cost = log2(name.length());
     data.marked = false;
 
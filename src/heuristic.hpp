@@ -0,0 +1,257 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "graph.hpp"
+#include "csr_graph.hpp"
+#include "compiled_configuration.hpp"
+
+/* Admissible heuristic for the A* search on supernodes.
+    Lower bounds are computed once per subassembly of the original And/Or graph by a bottom-up pass.
+    Every action is assumed to be executed by its cheapest agent.
+        total: minimal summed cost of all actions needed to assemble the subassembly.
+        critical path: minimal cost of the longest chain of dependent actions. Every action of the chain
+                       needs its own step, and a step costs at least the average of the actions executed in it.
+    The cost of a step is the average over at most N (number of agents) actions.
+    Therefore the remaining cost of a supernode is bounded by the summed totals divided by N
+    and by the largest critical path of its subassemblies.
+        next step: the next step averages actions of the remaining subassemblies, every one of them costs
+                   at least the cheapest action available to the supernode.
+    The next step bound is consistent on its own, as it bounds the cost of every edge leaving the supernode.
+    The evaluation of a supernode is a lookup per remaining subassembly and pending interaction of its SearchState.
+**/
+class Heuristic
+{
+public:
+    Heuristic(const CsrGraph *, config::CompiledConfiguration *);
+
+    // Lower bound of the remaining cost of a supernode.
+    double operator()(const NodeData &) const;
+
+    // Components of the lower bound for the batch evaluation (scoreBatch):
+    // h = max(max(total / agents, critical path), next step).
+    void components(const NodeData &, double &, double &, double &) const;
+    double agents() const;
+
+    // Lower bound of the summed action costs of the remaining subassemblies of a supernode.
+    double total(const NodeData &) const;
+
+    // Lower bounds of a subassembly. Indexed by the config_index of the Or-Node.
+    double total(std::size_t) const;
+    double criticalPath(std::size_t) const;
+
+private:
+    void compute(const CsrGraph *, std::size_t);
+    double stepCost(std::size_t) const;
+    template <typename Function>
+    void forEachBound(const SearchState &, Function) const;
+
+    // Snapshot of the original graph and the configuration holding the interaction slots.
+    const CsrGraph *graph_;
+    config::CompiledConfiguration *config_;
+
+    // Cheapest agent cost of every action.
+    std::vector<double> min_action_cost_;
+
+    // Cheapest cost of any action. Lower bound for the cost of every action in a step.
+    double min_cost_;
+    double n_agents_;
+
+    // Cheapest cost of any agent for any action of a subassembly.
+    // Single parts have no action, their cheapest action costs INFINITY.
+    std::vector<double> cheapest_action_;
+
+    // Lower bounds of every subassembly and flag if they are computed already.
+    std::vector<double> total_;
+    std::vector<double> critical_path_;
+    std::vector<bool> computed_;
+};
+
+/* Constructor. Computes the lower bounds of all subassemblies.
+    @graph: snapshot of the original And/Or graph. The config_index of its nodes has to be set by the CompiledConfiguration.
+    @config: compiled configuration containing the cost table.
+**/
+Heuristic::Heuristic(const CsrGraph *graph, config::CompiledConfiguration *config)
+{
+    graph_ = graph;
+    config_ = config;
+    n_agents_ = std::max<std::size_t>(config->numberOfAgents(), 1);
+
+    min_cost_ = INFINITY;
+    min_action_cost_.assign(config->numberOfActions(), INFINITY);
+    for (std::size_t action = 0; action < config->numberOfActions(); action++)
+    {
+        for (std::size_t agent = 0; agent < config->numberOfAgents(); agent++)
+        {
+            min_action_cost_[action] = std::min(min_action_cost_[action], config->cost(action, agent));
+        }
+        min_cost_ = std::min(min_cost_, min_action_cost_[action]);
+    }
+    if (min_cost_ == INFINITY)
+        min_cost_ = 0;
+
+    cheapest_action_.assign(config->numberOfSubassemblies(), INFINITY);
+    for (std::size_t id = 0; id < graph->numberOfNodes(); id++)
+    {
+        if (graph->type(id) != NodeType::OR)
+            continue;
+        std::size_t index = graph->configIndex(id);
+        for (auto action : graph->successors(id))
+        {
+            std::size_t action_index = graph->configIndex(action);
+            cheapest_action_[index] = std::min(cheapest_action_[index], min_action_cost_[action_index]);
+        }
+    }
+
+    total_.assign(config->numberOfSubassemblies(), 0);
+    critical_path_.assign(config->numberOfSubassemblies(), 0);
+    computed_.assign(config->numberOfSubassemblies(), false);
+
+    for (std::size_t id = 0; id < graph->numberOfNodes(); id++)
+    {
+        if (graph->type(id) == NodeType::OR)
+            compute(graph, id);
+    }
+}
+
+/* Compute the lower bounds of a subassembly after the ones of its parts.
+    @graph: snapshot of the original graph.
+    @node: id of the Or-Node.
+**/
+void Heuristic::compute(const CsrGraph *graph, std::size_t node)
+{
+    std::size_t index = graph->configIndex(node);
+    if (computed_[index])
+        return;
+    computed_[index] = true;
+
+    // Single parts do not need any action.
+    if (!graph->hasSuccessor(node))
+        return;
+
+    double best_total = INFINITY;
+    double best_critical_path = INFINITY;
+    for (auto action : graph->successors(node))
+    {
+        std::size_t action_index = graph->configIndex(action);
+        double action_total = min_action_cost_[action_index];
+        double action_critical_path = 0;
+        for (auto part : graph->successors(action))
+        {
+            compute(graph, part);
+            action_total += total_[graph->configIndex(part)];
+            action_critical_path = std::max(action_critical_path, critical_path_[graph->configIndex(part)]);
+        }
+        action_critical_path += stepCost(action_index);
+
+        best_total = std::min(best_total, action_total);
+        best_critical_path = std::min(best_critical_path, action_critical_path);
+    }
+
+    total_[index] = best_total;
+    critical_path_[index] = best_critical_path;
+}
+
+/* Lower bound of the cost of a step executing a given action.
+    The other actions of the step cost at least min_cost_. The average decreases with the number of
+    actions in the step, so the bound assumes that all agents are busy.
+    @action: id of the action.
+**/
+double Heuristic::stepCost(std::size_t action) const
+{
+    return (min_action_cost_[action] + (n_agents_ - 1) * min_cost_) / n_agents_;
+}
+
+/* Calculate the lower bound of the remaining cost of a supernode.
+    @data: data of the supernode.
+    \return: admissible h_score.
+**/
+double Heuristic::operator()(const NodeData &data) const
+{
+    double sum, critical_path, next_step;
+    components(data, sum, critical_path, next_step);
+    return std::max(std::max(sum / n_agents_, critical_path), next_step);
+}
+
+/* Calculate the components of the lower bound of a supernode.
+    The lookups per subassembly can not be vectorized, the combination of the components can.
+    @data: data of the supernode.
+    @sum: set to the summed lower bound of the remaining subassemblies.
+    @critical_path: set to the largest critical path of the remaining subassemblies.
+    @next_step: set to the lower bound of the next step, the cheapest action of the remaining subassemblies.
+                Zero if no action remains.
+**/
+void Heuristic::components(const NodeData &data, double &sum, double &critical_path, double &next_step) const
+{
+    sum = 0;
+    critical_path = 0;
+    double cheapest = INFINITY;
+    forEachBound(data.state, [&](double node_total, double node_critical_path, double node_cheapest) {
+        sum += node_total;
+        critical_path = std::max(critical_path, node_critical_path);
+        cheapest = std::min(cheapest, node_cheapest);
+    });
+    next_step = cheapest == INFINITY ? 0 : cheapest;
+}
+
+/* Number of agents the summed lower bound is divided by. At least one.
+**/
+inline double
+Heuristic::agents() const
+{
+    return n_agents_;
+}
+
+/* Lower bound of the summed action costs of all remaining subassemblies of a supernode.
+    Decreases along a step by at most the summed cost of the actions executed in it.
+    So (total(a) - total(b)) / N is a consistent lower bound of the cost from supernode a to supernode b.
+    @data: data of the supernode.
+**/
+double Heuristic::total(const NodeData &data) const
+{
+    double sum = 0;
+    forEachBound(data.state, [&](double node_total, double, double) { sum += node_total; });
+    return sum;
+}
+
+/* Call a function with the lower bounds of every remaining subassembly of a supernode:
+    the summed action costs, the critical path and the cost of its cheapest action (INFINITY for a single part).
+    A subassembly waiting for an interaction needs the interaction on top of the bounds of the subassembly,
+    and the interaction is its only available action.
+    @state: state of the supernode.
+    @function: called with (total, critical path, cheapest action) per subassembly.
+**/
+template <typename Function>
+void Heuristic::forEachBound(const SearchState &state, Function function) const
+{
+    state.forEachSubassembly([&](std::size_t id) {
+        std::size_t index = graph_->configIndex(id);
+        function(total_[index], critical_path_[index], cheapest_action_[index]);
+    });
+    state.forEachInteraction([&](std::size_t slot) {
+        std::size_t index = config_->slotSubassembly(slot);
+        std::size_t interaction = config_->slotInteraction(slot);
+        function(total_[index] + min_action_cost_[interaction], critical_path_[index] + stepCost(interaction),
+                 min_action_cost_[interaction]);
+    });
+}
+
+/* Lower bound of the summed action costs of a subassembly.
+    @subassembly: config_index of the Or-Node.
+**/
+inline double
+Heuristic::total(std::size_t subassembly) const
+{
+    return total_[subassembly];
+}
+
+/* Lower bound of the cost of the longest chain of actions of a subassembly.
+    @subassembly: config_index of the Or-Node.
+**/
+inline double
+Heuristic::criticalPath(std::size_t subassembly) const
+{
+    return critical_path_[subassembly];
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+#include "astar.hpp"
+#include "heuristic.hpp"
+
+/* Memory-bounded search. Iterative deepening A* (IDA*) with a bounded transposition table.
+    Each iteration is a depth-first search which only follows supernodes with an f_score up to a threshold.
+    The threshold starts at the f_score of the root and is raised to the lowest f_score exceeding it.
+    Only the current path and the children of the supernodes on it are kept inside the search graph.
+    The children are erased once their subtree has been searched.
+    The same state is reached through many action orders and agent permutations, so the best g_score of
+    the visited states is cached. The cache shares the node budget with the search graph.
+    It stops growing once the budget is used up, so duplicates are only pruned as long as memory permits.
+    With an admissible heuristic the first goal found is optimal.
+**/
+class IDAStarSearch
+{
+public:
+    IDAStarSearch(config::SearchOptions options = config::SearchOptions(), Heuristic *heuristic = nullptr);
+
+    // Search function. The search graph must not place its nodes inside an arena,
+    // as the memory of erased supernodes has to be freed.
+    Node *search(Graph<> *, Node *, NodeExpander *);
+
+    const SearchStatistics &statistics() const;
+
+    // Outcome of the last search. NodeBudget if a single path needs more supernodes than the budget.
+    SearchStatus status() const;
+
+    // Largest number of supernodes held in the search graph at the same time.
+    std::size_t peakNodes() const;
+
+    // Number of iterations of the last search.
+    std::size_t iterations() const;
+
+private:
+    // Best g_score of a visited state and the iteration it was visited with that g_score.
+    struct Visit
+    {
+        SearchState state;
+        double g_score;
+        std::size_t iteration;
+    };
+
+    double depthFirst(Node *, double);
+    bool visit(Node *);
+    double calcHScore(Node *) const;
+
+    Graph<> *graph_;
+    NodeExpander *expander_;
+    Heuristic *heuristic_;
+
+    // Maximum number of supernodes in the search graph plus cached states.
+    std::size_t node_budget_;
+    std::size_t live_nodes_;
+    std::size_t peak_nodes_;
+
+    std::unordered_multimap<std::size_t, Visit> visited_;
+    std::size_t iteration_;
+
+    Node *goal_;
+    // Deepest supernode of the path on which the budget ran out. Its path is kept as the partial plan.
+    Node *stopped_;
+    SearchStatus status_;
+    SearchStatistics statistics_;
+};
+
+/* Constructor
+    @options: node_budget: maximum number of supernodes inside the search graph plus cached states.
+    @heuristic: admissible heuristic. If nullptr, zero is used and the search deepens by the cheapest step.
+                The legacy heuristic is not admissible and is not supported.
+**/
+IDAStarSearch::IDAStarSearch(config::SearchOptions options, Heuristic *heuristic)
+{
+    node_budget_ = options.node_budget;
+    heuristic_ = heuristic;
+    graph_ = nullptr;
+    expander_ = nullptr;
+    live_nodes_ = 0;
+    peak_nodes_ = 0;
+    iteration_ = 0;
+    goal_ = nullptr;
+    stopped_ = nullptr;
+    status_ = SearchStatus::Exhausted;
+}
+
+/* Perform the IDA* search.
+    @graph: pointer to graph on which the search should be performed. Contains only the root.
+    @root: pointer to node at which the search should begin.
+    @exapnder: exapnder object used for node expansion.
+    \return: the optimal goal supernode. The root if no goal exists.
+             The deepest supernode of the current path if the node budget is exceeded.
+**/
+Node *IDAStarSearch::search(Graph<> *graph, Node *root, NodeExpander *expander)
+{
+    graph_ = graph;
+    expander_ = expander;
+    statistics_ = SearchStatistics();
+    visited_.clear();
+    live_nodes_ = 1;
+    peak_nodes_ = 1;
+    iteration_ = 0;
+    goal_ = nullptr;
+    stopped_ = nullptr;
+    status_ = SearchStatus::Exhausted;
+
+    root->data_.g_score = 0;
+    root->data_.h_score = calcHScore(root);
+    root->data_.calc_fscore();
+
+    double threshold = root->data_.f_score;
+    while (true)
+    {
+        iteration_++;
+        visit(root);
+        double next_threshold = depthFirst(root, threshold);
+
+        if (goal_)
+        {
+            status_ = SearchStatus::Solved;
+            return goal_;
+        }
+        if (stopped_)
+        {
+            status_ = SearchStatus::NodeBudget;
+            return stopped_;
+        }
+        if (next_threshold == INFINITY)
+            return root;
+        threshold = next_threshold;
+    }
+}
+
+/* Search the subtree of a supernode up to a threshold.
+    @node: supernode with valid g_score and f_score.
+    @threshold: maximum f_score of the searched supernodes.
+    \return: lowest f_score exceeding the threshold inside the subtree. INFINITY if there is none.
+             If a goal is found, it is stored in goal_ and the path to it is kept.
+             If the budget is exceeded, the supernode is stored in stopped_ and the path to it is kept.
+**/
+double IDAStarSearch::depthFirst(Node *node, double threshold)
+{
+    if (node->data_.f_score > threshold)
+        return node->data_.f_score;
+
+    if (node->data_.isGoal())
+    {
+        goal_ = node;
+        return node->data_.f_score;
+    }
+
+    expander_->expandNode(node);
+    statistics_.expansions++;
+    statistics_.generated += node->numberOfSuccessors();
+
+    live_nodes_ += node->numberOfSuccessors();
+    peak_nodes_ = std::max(peak_nodes_, live_nodes_);
+    statistics_.peak_open = peak_nodes_;
+    if (live_nodes_ > node_budget_)
+    {
+        std::cerr << "Search path needs " << live_nodes_ << " supernodes. "
+                  << "Only " << node_budget_ << " are allowed. Increase the node budget." << std::endl;
+        stopped_ = node;
+        return INFINITY;
+    }
+
+    // Children are searched in ascending order of their f_score, so a goal is found early in the last iteration.
+    std::vector<Node *> children;
+    children.reserve(node->numberOfSuccessors());
+    for (auto edge : node->successors())
+    {
+        Node *child = edge->getDestination();
+        child->data_.g_score = node->data_.g_score + edge->data_.cost;
+        child->data_.h_score = calcHScore(child);
+        child->data_.calc_fscore();
+        children.push_back(child);
+    }
+    std::stable_sort(children.begin(), children.end(),
+                     [](const Node *lhs, const Node *rhs) { return lhs->data_.f_score < rhs->data_.f_score; });
+
+    double next_threshold = INFINITY;
+    for (auto child : children)
+    {
+        if (child->data_.f_score > threshold)
+        {
+            next_threshold = std::min(next_threshold, child->data_.f_score);
+            continue;
+        }
+        if (!visit(child))
+            continue;
+
+        statistics_.queued++;
+        next_threshold = std::min(next_threshold, depthFirst(child, threshold));
+        if (goal_ || stopped_)
+            return next_threshold;
+    }
+
+    // The subtree is searched. Its supernodes are not needed anymore.
+    for (auto child : children)
+    {
+        graph_->eraseNode(child->id_);
+    }
+    live_nodes_ -= children.size();
+
+    return next_threshold;
+}
+
+/* Record the visit of a supernode inside the transposition table.
+    @node: supernode with valid g_score.
+    \return: false if the state was already searched with a lower g_score, or with the same g_score
+             in the current iteration. True otherwise.
+**/
+bool IDAStarSearch::visit(Node *node)
+{
+    std::size_t hash = node->data_.state.hash();
+    auto range = visited_.equal_range(hash);
+    for (auto it = range.first; it != range.second; it++)
+    {
+        Visit &known = it->second;
+        if (known.state != node->data_.state)
+            continue;
+
+        if (known.g_score < node->data_.g_score ||
+            (known.g_score == node->data_.g_score && known.iteration == iteration_))
+        {
+            statistics_.duplicates++;
+            return false;
+        }
+        known.g_score = node->data_.g_score;
+        known.iteration = iteration_;
+        return true;
+    }
+
+    // The cache only grows while the budget permits.
+    if (live_nodes_ + visited_.size() < node_budget_)
+        visited_.insert(std::make_pair(hash, Visit{node->data_.state, node->data_.g_score, iteration_}));
+    return true;
+}
+
+/* Calculate the h_score of a supernode which is not expanded yet.
+**/
+double IDAStarSearch::calcHScore(Node *node) const
+{
+    return heuristic_ ? (*heuristic_)(node->data_) : 0;
+}
+
+/* Get the counters collected during the last search.
+**/
+const SearchStatistics &IDAStarSearch::statistics() const
+{
+    return statistics_;
+}
+
+SearchStatus IDAStarSearch::status() const
+{
+    return status_;
+}
+
+std::size_t IDAStarSearch::peakNodes() const
+{
+    return peak_nodes_;
+}
+
+std::size_t IDAStarSearch::iterations() const
+{
+    return iteration_;
+}
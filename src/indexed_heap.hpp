@@ -0,0 +1,248 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+#include "graph.hpp"
+
+/* Indexed d-ary heap of supernodes.
+    Used as open-set of the A* search. The position of every supernode inside the heap is stored
+    in NodeData::heap_index, so a supernode can be found, updated and removed in logarithmic time.
+    The comparator has the semantic of std::priority_queue: compare(a, b) is true if a has a lower priority than b.
+    A supernode can be contained in one heap at a time.
+**/
+template <typename Compare, std::size_t Arity = 4>
+class IndexedHeap
+{
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    IndexedHeap(const Compare &compare = Compare());
+    ~IndexedHeap();
+
+    bool empty() const;
+    std::size_t size() const;
+    bool contains(const Node *) const;
+
+    Node *top() const;
+    void push(Node *);
+    void pop();
+
+    // Push several supernodes at once. Rebuilds the heap if that is cheaper than inserting them one by one.
+    void pushAll(const std::vector<Node *> &);
+
+    // Restore the heap after the f_score of a contained supernode changed in any direction.
+    void update(Node *);
+    void remove(Node *);
+    void clear();
+
+private:
+    void siftUp(std::size_t);
+    void siftDown(std::size_t);
+    void place(Node *, std::size_t);
+
+    std::vector<Node *> heap_;
+    Compare compare_;
+};
+
+/* Constructor. Creates an empty heap.
+    @compare: comparator, compare(a, b) is true if a has a lower priority than b.
+**/
+template <typename Compare, std::size_t Arity>
+inline IndexedHeap<Compare, Arity>::IndexedHeap(const Compare &compare)
+    : compare_(compare)
+{
+    static_assert(Arity >= 2, "IndexedHeap requires an arity of at least two.");
+}
+
+/* Destructor. The contained supernodes are released from the heap.
+**/
+template <typename Compare, std::size_t Arity>
+inline IndexedHeap<Compare, Arity>::~IndexedHeap()
+{
+    clear();
+}
+
+template <typename Compare, std::size_t Arity>
+inline bool
+IndexedHeap<Compare, Arity>::empty() const
+{
+    return heap_.empty();
+}
+
+template <typename Compare, std::size_t Arity>
+inline std::size_t
+IndexedHeap<Compare, Arity>::size() const
+{
+    return heap_.size();
+}
+
+/* Check if a supernode is contained in this heap.
+**/
+template <typename Compare, std::size_t Arity>
+inline bool
+IndexedHeap<Compare, Arity>::contains(const Node *node) const
+{
+    std::size_t index = node->data_.heap_index;
+    return index < heap_.size() && heap_[index] == node;
+}
+
+/* Obtain the supernode with the highest priority. The heap must not be empty.
+**/
+template <typename Compare, std::size_t Arity>
+inline Node *
+IndexedHeap<Compare, Arity>::top() const
+{
+    return heap_.front();
+}
+
+/* Insert a supernode.
+    @node: supernode which is not contained in any heap.
+**/
+template <typename Compare, std::size_t Arity>
+inline void
+IndexedHeap<Compare, Arity>::push(Node *node)
+{
+    heap_.push_back(node);
+    node->data_.heap_index = heap_.size() - 1;
+    siftUp(heap_.size() - 1);
+}
+
+/* Remove the supernode with the highest priority. The heap must not be empty.
+**/
+template <typename Compare, std::size_t Arity>
+inline void
+IndexedHeap<Compare, Arity>::pop()
+{
+    remove(heap_.front());
+}
+
+/* Insert the supernodes of a whole expansion.
+    Appending and rebuilding the heap costs O(n + k), inserting one by one O(k log n).
+    @nodes: supernodes which are not contained in any heap.
+**/
+template <typename Compare, std::size_t Arity>
+inline void
+IndexedHeap<Compare, Arity>::pushAll(const std::vector<Node *> &nodes)
+{
+    // Rebuild if the batch is large compared to the heap. The factor is the depth of a heap of moderate size.
+    if (nodes.size() * 8 < heap_.size())
+    {
+        for (auto node : nodes)
+            push(node);
+        return;
+    }
+
+    for (auto node : nodes)
+    {
+        node->data_.heap_index = heap_.size();
+        heap_.push_back(node);
+    }
+    if (heap_.size() < 2)
+        return;
+    for (std::size_t i = (heap_.size() - 2) / Arity + 1; i-- > 0;)
+        siftDown(i);
+}
+
+/* Restore the heap property after the priority of a supernode changed.
+    @node: contained supernode.
+**/
+template <typename Compare, std::size_t Arity>
+inline void
+IndexedHeap<Compare, Arity>::update(Node *node)
+{
+    std::size_t index = node->data_.heap_index;
+    siftUp(index);
+    if (heap_[index] == node)
+        siftDown(index);
+}
+
+/* Remove a supernode.
+    @node: contained supernode.
+**/
+template <typename Compare, std::size_t Arity>
+inline void
+IndexedHeap<Compare, Arity>::remove(Node *node)
+{
+    std::size_t index = node->data_.heap_index;
+    Node *last = heap_.back();
+    heap_.pop_back();
+    node->data_.heap_index = npos;
+
+    if (last == node)
+        return;
+
+    place(last, index);
+    update(last);
+}
+
+/* Remove all supernodes.
+**/
+template <typename Compare, std::size_t Arity>
+inline void
+IndexedHeap<Compare, Arity>::clear()
+{
+    for (auto node : heap_)
+        node->data_.heap_index = npos;
+    heap_.clear();
+}
+
+/* Move a supernode towards the root until its parent has a higher priority.
+**/
+template <typename Compare, std::size_t Arity>
+inline void
+IndexedHeap<Compare, Arity>::siftUp(std::size_t index)
+{
+    Node *node = heap_[index];
+    while (index > 0)
+    {
+        std::size_t parent = (index - 1) / Arity;
+        if (!compare_(heap_[parent], node))
+            break;
+        place(heap_[parent], index);
+        index = parent;
+    }
+    place(node, index);
+}
+
+/* Move a supernode towards the leaves until all its children have a lower priority.
+**/
+template <typename Compare, std::size_t Arity>
+inline void
+IndexedHeap<Compare, Arity>::siftDown(std::size_t index)
+{
+    Node *node = heap_[index];
+    std::size_t size = heap_.size();
+    while (true)
+    {
+        std::size_t first = index * Arity + 1;
+        if (first >= size)
+            break;
+
+        // Child with the highest priority.
+        std::size_t best = first;
+        std::size_t last = first + Arity < size ? first + Arity : size;
+        for (std::size_t child = first + 1; child < last; child++)
+        {
+            if (compare_(heap_[best], heap_[child]))
+                best = child;
+        }
+
+        if (!compare_(node, heap_[best]))
+            break;
+        place(heap_[best], index);
+        index = best;
+    }
+    place(node, index);
+}
+
+/* Store a supernode at a position and record the position inside the supernode.
+**/
+template <typename Compare, std::size_t Arity>
+inline void
+IndexedHeap<Compare, Arity>::place(Node *node, std::size_t index)
+{
+    heap_[index] = node;
+    node->data_.heap_index = index;
+}
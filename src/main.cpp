@@ -6,8 +6,11 @@
 #include <chrono>
 
 #include "planner.hpp"
+#include "report.hpp"
+#include "plan_cache.hpp"
 #include "dotwriter.hpp"
 #include "input_reader.hpp"
+#include "compiled_configuration.hpp"
 #include "argparse.hpp"
 #include "supervisor.hpp"
 
@@ -17,6 +20,93 @@ int main(int argc, char *argv[])
     argparse::ArgumentParser program("MSRM Assembly Planner");
     program.add_argument("Filename")
         .help("Path to the XML assembly description.");
+    program.add_argument("--lazy")
+        .help("Expand supernodes when they leave the open-set instead of when they are generated.")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("--partial")
+        .help("Create the successors of a supernode in ascending order of their cost (partial expansion).")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("--legacy-heuristic")
+        .help("Use the heuristic based on the subassembly names instead of the admissible And/Or lower bound.")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("--threads")
+        .help("Number of threads of the search. More than one selects the parallel hash-distributed A*.")
+        .default_value(std::size_t(1))
+        .action([](const std::string &value) { return std::size_t(std::stoul(value)); });
+    program.add_argument("--expansion-threads")
+        .help("Number of threads building the successors of a single supernode in the sequential search.")
+        .default_value(std::size_t(1))
+        .action([](const std::string &value) { return std::size_t(std::stoul(value)); });
+    program.add_argument("--anytime")
+        .help("Publish a first plan quickly and improve it until it is optimal or the deadline is reached (ARA*).")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("--epsilon")
+        .help("Initial weight of the heuristic in the anytime search.")
+        .default_value(3.0)
+        .action([](const std::string &value) { return std::stod(value); });
+    program.add_argument("--epsilon-step")
+        .help("Amount the weight of the heuristic is lowered by after every plan of the anytime search.")
+        .default_value(0.5)
+        .action([](const std::string &value) { return std::stod(value); });
+    program.add_argument("--deadline")
+        .help("Time budget of the anytime search in milliseconds. 0 for no limit.")
+        .default_value(std::size_t(0))
+        .action([](const std::string &value) { return std::size_t(std::stoul(value)); });
+    program.add_argument("--node-budget")
+        .help("Maximum number of supernodes kept in memory. Selects the memory-bounded IDA*. 0 for no limit.")
+        .default_value(std::size_t(0))
+        .action([](const std::string &value) { return std::size_t(std::stoul(value)); });
+    program.add_argument("--beam")
+        .help("Width of the beam search. Keeps the given number of supernodes per step. 0 for the optimal A*.")
+        .default_value(std::size_t(0))
+        .action([](const std::string &value) { return std::size_t(std::stoul(value)); });
+    program.add_argument("--greedy")
+        .help("Use the greedy best-first search ordered by the heuristic only.")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("--open-limit")
+        .help("Maximum number of supernodes in the open-set of the greedy search. The worst ones are dropped.")
+        .default_value(std::size_t(10000))
+        .action([](const std::string &value) { return std::size_t(std::stoul(value)); });
+    program.add_argument("--no-seed")
+        .help("Do not start the anytime and the beam search with the plan of the greedy descent.")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("--report-gap")
+        .help("After a beam or greedy search, run the optimal A* and report the cost gap.")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("--time-limit")
+        .help("Time limit of the A* search in milliseconds. Returns the best partial plan when reached. 0 for no limit.")
+        .default_value(std::size_t(0))
+        .action([](const std::string &value) { return std::size_t(std::stoul(value)); });
+    program.add_argument("--expansion-limit")
+        .help("Maximum number of expansions of the A* search. Returns the best partial plan when reached. 0 for no limit.")
+        .default_value(std::size_t(0))
+        .action([](const std::string &value) { return std::size_t(std::stoul(value)); });
+    program.add_argument("--memory-limit")
+        .help("Maximum memory of the Node and Edge objects of the A* search graph in MiB (its arena). "
+              "Heap memory owned by them is not counted. Returns the best partial plan when reached. 0 for no limit.")
+        .default_value(std::size_t(0))
+        .action([](const std::string &value) { return std::size_t(std::stoul(value)); });
+    program.add_argument("--cache")
+        .help("Directory of the persistent plan cache. Solved plans are stored and reused for identical requests.")
+        .default_value(std::string(""));
+    program.add_argument("--cache-size")
+        .help("Maximum number of plans kept in the cache. The least recently used ones are deleted.")
+        .default_value(std::size_t(100))
+        .action([](const std::string &value) { return std::size_t(std::stoul(value)); });
+    program.add_argument("--execute-partial")
+        .help("Execute the partial plan of a search stopped by a limit. By default only solved plans are executed.")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("--stats")
+        .help("Write the search statistics and phase timings as JSON to the given file. - for stdout, the other output is then written to stderr.")
+        .default_value(std::string(""));
 
     // Parse Input Block
     try
@@ -32,14 +122,117 @@ int main(int argc, char *argv[])
 
     auto input = program.get<std::string>("Filename");
 
+    config::SearchOptions options;
+    options.lazy_expansion = program.get<bool>("--lazy");
+    options.partial_expansion = program.get<bool>("--partial");
+    options.legacy_heuristic = program.get<bool>("--legacy-heuristic");
+    options.threads = program.get<std::size_t>("--threads");
+    options.expansion_threads = program.get<std::size_t>("--expansion-threads");
+    options.anytime = program.get<bool>("--anytime");
+    options.initial_epsilon = program.get<double>("--epsilon");
+    options.epsilon_step = program.get<double>("--epsilon-step");
+    options.deadline = program.get<std::size_t>("--deadline");
+    options.node_budget = program.get<std::size_t>("--node-budget");
+    options.beam_width = program.get<std::size_t>("--beam");
+    options.greedy = program.get<bool>("--greedy");
+    options.greedy_open_limit = program.get<std::size_t>("--open-limit");
+    options.seed_incumbent = !program.get<bool>("--no-seed");
+    options.report_gap = program.get<bool>("--report-gap");
+    options.time_limit = program.get<std::size_t>("--time-limit");
+    options.expansion_limit = program.get<std::size_t>("--expansion-limit");
+    options.memory_limit = program.get<std::size_t>("--memory-limit") * 1024 * 1024;
+
+    // Only one search algorithm can be selected.
+    int modes = int(options.threads > 1) + int(options.anytime) + int(options.node_budget > 0) +
+                int(options.beam_width > 0) + int(options.greedy);
+    if (modes > 1)
+    {
+        std::cerr << "Only one of --threads, --anytime, --node-budget, --beam and --greedy can be selected." << std::endl;
+        return 1;
+    }
+
+    // The legacy heuristic is only known after the expansion and is only evaluated by the A* search.
+    // The other searches would run without any heuristic.
+    if (options.legacy_heuristic && (options.greedy || options.anytime || options.node_budget > 0 || options.beam_width > 0))
+    {
+        std::cerr << "--legacy-heuristic can not be combined with --greedy, --anytime, --node-budget or --beam." << std::endl;
+        return 1;
+    }
+
+    // The gap and the open-set limit only apply to the non-optimal searches.
+    if (options.report_gap && !options.greedy && options.beam_width == 0)
+    {
+        std::cerr << "--report-gap requires --beam or --greedy." << std::endl;
+        return 1;
+    }
+    config::SearchOptions defaults;
+    if (!options.greedy && options.greedy_open_limit != defaults.greedy_open_limit)
+    {
+        std::cerr << "--open-limit requires --greedy." << std::endl;
+        return 1;
+    }
+
+    // The weights and the deadline are only honored by the anytime search, the seed also by the beam search.
+    if (!options.anytime && (options.initial_epsilon != defaults.initial_epsilon ||
+                             options.epsilon_step != defaults.epsilon_step || options.deadline > 0))
+    {
+        std::cerr << "--epsilon, --epsilon-step and --deadline require --anytime." << std::endl;
+        return 1;
+    }
+    if (!options.anytime && options.beam_width == 0 && !options.seed_incumbent)
+    {
+        std::cerr << "--no-seed requires --anytime or --beam." << std::endl;
+        return 1;
+    }
+
+    // Lazy and partial expansion are only honored by the A* search.
+    bool astar = !options.anytime && options.node_budget == 0 && options.beam_width == 0 && !options.greedy;
+    if (!astar && (options.lazy_expansion || options.partial_expansion))
+    {
+        std::cerr << "--lazy and --partial can not be combined with --anytime, --node-budget, --beam or --greedy." << std::endl;
+        return 1;
+    }
+
+    // The limits are only honored by the A* search.
+    bool limited = options.time_limit > 0 || options.expansion_limit > 0 || options.memory_limit > 0;
+    if (limited && (options.threads > 1 || options.anytime || options.node_budget > 0 || options.beam_width > 0 || options.greedy))
+    {
+        std::cerr << "--time-limit, --expansion-limit and --memory-limit can not be combined with "
+                  << "--threads, --anytime, --node-budget, --beam or --greedy." << std::endl;
+        return 1;
+    }
+
+    // The parallel search expands eagerly with the admissible heuristic and one thread per supernode.
+    if (options.threads > 1 && (options.lazy_expansion || options.partial_expansion ||
+                                options.expansion_threads > 1 || options.legacy_heuristic))
+    {
+        std::cerr << "--threads can not be combined with --lazy, --partial, --expansion-threads or --legacy-heuristic." << std::endl;
+        return 1;
+    }
+
+    auto stats_path = program.get<std::string>("--stats");
+    auto cache_path = program.get<std::string>("--cache");
+
+    // With --stats -, stdout only carries the report. The human-readable output is moved to stderr.
+    std::ostream report_stream(std::cout.rdbuf());
+    if (stats_path == "-")
+        std::cout.rdbuf(std::cerr.rdbuf());
+
     // Assembly Plan is a vector containg tuples of <action_pointer, agent_name, cost>
     std::vector< std::vector<Task*>> assembly_plan;
 
+    // Wall time of the phases for the report.
+    PhaseTimes times;
+    auto since = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
     // Assembly Planning Block.
     Graph<> *assembly;
 
     try
     {
+        auto phase_start = std::chrono::steady_clock::now();
         InputReader rdr(input);
         config::Configuration *config;
 
@@ -54,11 +247,66 @@ int main(int argc, char *argv[])
             return false;
         }
         
-        Planner planner;
-        assembly_plan = planner(assembly, assembly->root_, config);
+        // Intern the agents, actions and subassemblies once for the search.
+        config::CompiledConfiguration tables(config, assembly);
+        times.parse = since(phase_start);
+
+        phase_start = std::chrono::steady_clock::now();
+        Planner planner(options);
+        PlanningStatistics plan_statistics;
 
-        Supervisor execution_supervisor(config);
-        execution_supervisor.run(assembly_plan);
+        // Identical requests are answered from the cache. Only solved plans are stored. A plan of the anytime search
+        // above the optimal bound depends on when its deadline hit, so it is not reused.
+        std::unique_ptr<PlanCache> cache;
+        std::uint64_t cache_key = 0;
+        double search_cost = 0;
+        if (!cache_path.empty())
+        {
+            cache.reset(new PlanCache(cache_path, program.get<std::size_t>("--cache-size")));
+            cache_key = PlanCache::key(assembly, &tables, options);
+        }
+        if (cache && cache->load(cache_key, assembly_plan, search_cost))
+        {
+            plan_statistics.mode = "cache";
+            plan_statistics.solved = true;
+            plan_statistics.status = toString(SearchStatus::Solved);
+            plan_statistics.search_cost = search_cost;
+            for (auto &step : assembly_plan)
+                for (auto task : step)
+                    plan_statistics.plan_cost += task->cost_;
+            plan_statistics.plan_steps = assembly_plan.size();
+            std::cout << "Plan loaded from the cache. Cost: " << plan_statistics.plan_cost << std::endl;
+        }
+        else
+        {
+            assembly_plan = planner(assembly, assembly->root_, &tables);
+            plan_statistics = planner.statistics();
+            if (cache && plan_statistics.solved && plan_statistics.bound <= 1)
+                cache->store(cache_key, assembly_plan, plan_statistics.search_cost);
+        }
+        times.plan = since(phase_start);
+
+        // A partial plan does not assemble the product. It is only executed on request.
+        bool execute = plan_statistics.solved || program.get<bool>("--execute-partial");
+        if (execute)
+        {
+            phase_start = std::chrono::steady_clock::now();
+            Supervisor execution_supervisor(config);
+            execution_supervisor.run(assembly_plan);
+            times.execute = since(phase_start);
+        }
+
+        if (stats_path == "-")
+            writeReport(report_stream, plan_statistics, times, cache ? &cache->statistics() : nullptr);
+        else if (!stats_path.empty())
+            writeReport(stats_path, plan_statistics, times, cache ? &cache->statistics() : nullptr);
+
+        if (!plan_statistics.solved)
+        {
+            std::cerr << "No complete plan found (" << plan_statistics.status << ")."
+                      << (execute ? "" : " The partial plan is not executed.") << std::endl;
+            return 2;
+        }
 
     }
     catch (const std::runtime_error &err)
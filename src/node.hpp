@@ -6,7 +6,8 @@
 #include <algorithm>
 #include <string>
 #include <unordered_map>
-#include "edge.hpp"
+#include <stdexcept>
+#include "edge_list.hpp"
 
 /* Class representing the Nodes within a graph. 
     Nodes can represent any type of data-structure.
@@ -37,6 +38,12 @@ public:
     std::vector<Node *> getSuccessorNodes();
     std::vector<Node *> getPredecessorNodes();
 
+    // Non-allocating access to the adjacency. Preferred inside loops.
+    const EdgeList &successors() const;
+    const EdgeList &predecessors() const;
+    NodeRange successorNodes() const;
+    NodeRange predecessorNodes() const;
+
     void print();
 
     bool visited = false;
@@ -44,8 +51,9 @@ public:
     NodeData data_;
 
 // private:
-    std::unordered_map<std::size_t, Edge *> parents_;
-    std::unordered_map<std::size_t, Edge *> children_;
+    // Edges in the order of their insertion.
+    EdgeList parents_;
+    EdgeList children_;
 };
 
 /* Constructor. 
@@ -83,7 +91,12 @@ Node::hasPredecessor(void) const
 inline Edge *
 Node::getSuccessor(std::size_t index) const
 {
-    return children_.at(index);
+    for (auto edge : children_)
+    {
+        if (edge->getDestination()->id_ == index)
+            return edge;
+    }
+    throw std::out_of_range("Node has no successor with the given id.");
 }
 
 /* Obtain predecessor edge connecting the node to the one specified by the index-id.
@@ -93,7 +106,12 @@ Node::getSuccessor(std::size_t index) const
 inline Edge *
 Node::getPredecessor(std::size_t index) const
 {
-    return parents_.at(index);
+    for (auto edge : parents_)
+    {
+        if (edge->getSource()->id_ == index)
+            return edge;
+    }
+    throw std::out_of_range("Node has no predecessor with the given id.");
 }
 
 /* Add provided edge to the set of predecessors of Node.
@@ -103,7 +121,7 @@ inline void
 Node::addPredecessor(
     Edge *predecessor)
 {
-    parents_.insert(std::make_pair(predecessor->getSource()->id_, predecessor));
+    parents_.push_back(predecessor);
 }
 
 /* Add provided edge to the set of successors of Node.
@@ -113,7 +131,7 @@ inline void
 Node::addSuccessor(
     Edge *successor)
 {
-    children_.insert(std::make_pair(successor->getDestination()->id_, successor));
+    children_.push_back(successor);
 }
 
 /* Remove Edge connecting the Node with the one specified by @predId from the set of predecessors.
@@ -123,7 +141,14 @@ inline void
 Node::removePredecessor(
     std::size_t predId)
 {
-    parents_.erase(predId);
+    for (auto it = parents_.begin(); it != parents_.end(); it++)
+    {
+        if ((*it)->getSource()->id_ == predId)
+        {
+            parents_.erase(it);
+            return;
+        }
+    }
 }
 
 /* Remove Edge connecting the Node with the one specified by @succId from the set of successors.
@@ -133,7 +158,14 @@ inline void
 Node::removeSuccessor(
     std::size_t succId)
 {
-    children_.erase(succId);
+    for (auto it = children_.begin(); it != children_.end(); it++)
+    {
+        if ((*it)->getDestination()->id_ == succId)
+        {
+            children_.erase(it);
+            return;
+        }
+    }
 }
 
 /* Get the number of successors connected to the Node.
@@ -161,14 +193,7 @@ Node::numberOfPredecessors() const
 inline std::vector<Edge *>
 Node::getSuccessors()
 {
-    std::vector<Edge *> vecOfValues;
-    vecOfValues.reserve(children_.size());
-
-    /*** Copy all value fields from map to a vector using Lambda function ***/
-    for (auto elem : children_)
-        vecOfValues.push_back(elem.second);
-
-    return vecOfValues;
+    return std::vector<Edge *>(children_.begin(), children_.end());
 }
 
 /* Obtain predecessor edge connecting the node to the one specified by the index-id.
@@ -178,14 +203,7 @@ Node::getSuccessors()
 inline std::vector<Edge *>
 Node::getPredecessors()
 {
-    std::vector<Edge *> vecOfValues;
-    vecOfValues.reserve(parents_.size());
-
-    /*** Copy all value fields from map to a vector using Lambda function ***/
-    for (auto elem : parents_)
-        vecOfValues.push_back(elem.second);
-
-    return vecOfValues;
+    return std::vector<Edge *>(parents_.begin(), parents_.end());
 }
 
 /* Obtain Successor Nodes. Skip connecting edges. Useful if graph not weighted.
@@ -194,14 +212,8 @@ Node::getPredecessors()
 inline std::vector<Node *>
 Node::getSuccessorNodes()
 {
-    std::vector<Node *> vecOfValues;
-    vecOfValues.reserve(children_.size());
-
-    /*** Copy all value fields from map to a vector using Lambda function ***/
-    for (auto elem : children_)
-        vecOfValues.push_back(elem.second->getDestination());
-
-    return vecOfValues;
+    NodeRange nodes = successorNodes();
+    return std::vector<Node *>(nodes.begin(), nodes.end());
 }
 
 /* Obtain Predecessor Nodes. Skip connecting edges. Useful if graph not weighted.
@@ -210,14 +222,44 @@ Node::getSuccessorNodes()
 inline std::vector<Node *>
 Node::getPredecessorNodes()
 {
-    std::vector<Node *> vecOfValues;
-    vecOfValues.reserve(parents_.size());
+    NodeRange nodes = predecessorNodes();
+    return std::vector<Node *>(nodes.begin(), nodes.end());
+}
+
+/* Obtain the successor edges without copying them.
+    \return: reference to the adjacency list. Invalidated if successors are added or removed.
+**/
+inline const EdgeList &
+Node::successors() const
+{
+    return children_;
+}
+
+/* Obtain the predecessor edges without copying them.
+    \return: reference to the adjacency list. Invalidated if predecessors are added or removed.
+**/
+inline const EdgeList &
+Node::predecessors() const
+{
+    return parents_;
+}
 
-    /*** Copy all value fields from map to a vector using Lambda function ***/
-    for (auto elem : parents_)
-        vecOfValues.push_back(elem.second->getSource());
+/* Obtain the successor nodes without copying them.
+    \return: range over the destinations of the successor edges.
+**/
+inline NodeRange
+Node::successorNodes() const
+{
+    return NodeRange(children_, true);
+}
 
-    return vecOfValues;
+/* Obtain the predecessor nodes without copying them.
+    \return: range over the sources of the predecessor edges.
+**/
+inline NodeRange
+Node::predecessorNodes() const
+{
+    return NodeRange(parents_, false);
 }
 
 /* DEBUG Function.
@@ -229,35 +271,29 @@ Node::print()
 }
 
 /* Check if given sueprnode is Goal.
-    Check whether a given supernode inside the A* search has any subassemblies to continue the search.
+    Check whether a given supernode inside the A* search has any actions or interactions to continue the search.
     Is declared as a member of the NodeData contained within Nodes.
     Placed within this files due to linking issues.
     //TODO: Move into containers.hpp and fix linking issues.
 **/
 bool NodeData::isGoal()
 {
-    for (auto &x : subassemblies)
-    {
-        if (x.second->hasSuccessor())
-        {
-            return false;
-        }
-    }
-    return true;
+    return state.isGoal();
 }
 
 /* Calculate the h_Score needed for the A* search.
+    @subassemblies: subassemblies of the supernode (NodeExpander::subassemblies).
     Is declared as a member of the NodeData contained within Nodes.
     Placed within this files due to linking issues.
     //TODO: Move into containers.hpp and fix linking issues.
 **/
-void NodeData::calc_hscore()
+void NodeData::calc_hscore(const std::vector<Node *> &subassemblies)
 {
     std::size_t maximum_length_subassembly = 0;
-    for (auto &x : subassemblies)
+    for (auto x : subassemblies)
     {
-        if (x.second->data_.name.length() > maximum_length_subassembly)
-            maximum_length_subassembly = x.second->data_.name.length();
+        if (x->data_.name.length() > maximum_length_subassembly)
+            maximum_length_subassembly = x->data_.name.length();
     }
     h_score = log2f(maximum_length_subassembly) * minimum_cost_action;
 }
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <queue>
+#include <cmath>
+
+#include "astar.hpp"
+#include "heuristic.hpp"
+#include "csr_graph.hpp"
+#include "compiled_configuration.hpp"
+
+/* Lock-free mailbox of a search worker.
+    Any thread can push supernodes, only the owning worker takes them.
+    Implemented as a Treiber stack. The owner takes the complete stack at once,
+    so popping single entries (and the ABA problem) is avoided.
+**/
+class Mailbox
+{
+public:
+    Mailbox();
+    ~Mailbox();
+
+    void push(Node *);
+    void takeAll(std::vector<Node *> &);
+    bool empty() const;
+
+private:
+    struct Message
+    {
+        Node *node;
+        Message *next;
+    };
+
+    std::atomic<Message *> head_;
+};
+
+/* Parallel A* search with hash-based work distribution (HDA*).
+    Every supernode is owned by the worker selected by the hash of its SearchState.
+    Each worker has its own open-set, transposition table, NodeExpander and search graph.
+    Generated supernodes are sent to the mailbox of their owner, so duplicates are always detected
+    by the same worker.
+    Goals do not stop the search. They update the incumbent, and supernodes whose f_score is not below
+    the incumbent cost are pruned. The search ends when no supernode is queued or in flight.
+    With an admissible heuristic the incumbent is then an optimal plan.
+    Workers without work sleep on a condition variable until a supernode is sent to them or the search ends.
+**/
+class ParallelAStarSearch
+{
+public:
+    ParallelAStarSearch(std::size_t, config::CompiledConfiguration *, const CsrGraph *, Heuristic * = nullptr);
+    ~ParallelAStarSearch();
+
+    // Search function
+    Node *search(Node *);
+
+    // Counters summed over all workers.
+    SearchStatistics statistics() const;
+    std::size_t arenaPeak() const;
+    ExpansionStatistics expansionStatistics() const;
+
+private:
+    struct Worker
+    {
+        Worker(config::CompiledConfiguration *config, const CsrGraph *original)
+            : graph(&arena), expander(&graph, config, original) {}
+
+        // The graph holds the supernodes generated by this worker. They stay valid until the search object
+        // is destroyed, as the found plan refers to supernodes of all workers.
+        Arena arena;
+        Graph<> graph;
+        NodeExpander expander;
+
+        std::priority_queue<Node *, std::vector<Node *>, LessThan> open;
+        TranspositionTable transpositions;
+        Mailbox mailbox;
+        std::vector<Node *> received;
+        SearchStatistics statistics;
+
+        // Wakes the worker while it sleeps without work. Senders only lock the mutex if the worker sleeps.
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::atomic<bool> sleeping{false};
+    };
+
+    void run(std::size_t);
+    void send(Node *);
+    void release();
+    void wake(Worker &);
+    void updateIncumbent(Node *);
+    void calcHScore(Node *);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    Heuristic *heuristic_;
+
+    // Number of supernodes which are queued in an open-set, in a mailbox or being expanded.
+    std::atomic<std::size_t> work_;
+
+    // Best goal found so far.
+    std::atomic<double> incumbent_cost_;
+    Node *incumbent_;
+    std::mutex incumbent_mutex_;
+};
+
+/* Constructor. Creates an empty mailbox.
+**/
+inline Mailbox::Mailbox()
+    : head_(nullptr)
+{
+}
+
+/* Destructor. Drops the remaining messages.
+**/
+inline Mailbox::~Mailbox()
+{
+    Message *message = head_.load();
+    while (message)
+    {
+        Message *next = message->next;
+        delete message;
+        message = next;
+    }
+}
+
+/* Send a supernode to the owner of the mailbox. Can be called from any thread.
+    @node: supernode. Must not be modified by the sender afterwards.
+**/
+inline void
+Mailbox::push(Node *node)
+{
+    // Sequentially consistent, so a sender which does not see the owner sleeping is seen by its check of empty().
+    Message *message = new Message{node, head_.load(std::memory_order_relaxed)};
+    while (!head_.compare_exchange_weak(message->next, message))
+        ;
+}
+
+/* Check if a supernode was received. Can be called from any thread.
+**/
+inline bool
+Mailbox::empty() const
+{
+    return head_.load() == nullptr;
+}
+
+/* Take all received supernodes. Only called by the owner.
+    @nodes: received supernodes are appended.
+**/
+inline void
+Mailbox::takeAll(std::vector<Node *> &nodes)
+{
+    Message *message = head_.exchange(nullptr, std::memory_order_acquire);
+    while (message)
+    {
+        nodes.push_back(message->node);
+        Message *next = message->next;
+        delete message;
+        message = next;
+    }
+}
+
+/* Constructor
+    @threads: number of worker threads.
+    @config: compiled configuration containing the cost_map and reachability_map.
+    @original: snapshot of the original And/Or graph.
+    @heuristic: admissible heuristic. If nullptr, zero is used (uniform-cost search).
+                The legacy heuristic needs the expansion of a supernode before it is pushed, which
+                does not fit the distribution of unexpanded supernodes.
+**/
+ParallelAStarSearch::ParallelAStarSearch(std::size_t threads,
+                                         config::CompiledConfiguration *config,
+                                         const CsrGraph *original,
+                                         Heuristic *heuristic)
+    : work_(0), incumbent_cost_(INFINITY)
+{
+    heuristic_ = heuristic;
+    incumbent_ = nullptr;
+    for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); i++)
+        workers_.emplace_back(new Worker(config, original));
+}
+
+/* Destructor. The supernodes of the workers are destroyed.
+**/
+ParallelAStarSearch::~ParallelAStarSearch()
+{
+}
+
+/* Perform the parallel A* search.
+    @root: pointer to node at which the search should begin. Its state has to be set.
+    \return: the best goal supernode. The root if no goal was found.
+**/
+Node *ParallelAStarSearch::search(Node *root)
+{
+    incumbent_ = nullptr;
+    incumbent_cost_ = INFINITY;
+
+    root->data_.g_score = 0;
+    calcHScore(root);
+    root->data_.calc_fscore();
+    send(root);
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < workers_.size(); i++)
+        threads.emplace_back(&ParallelAStarSearch::run, this, i);
+    for (auto &thread : threads)
+        thread.join();
+
+    return incumbent_ ? incumbent_ : root;
+}
+
+/* Main loop of a worker.
+    @index: index of the worker.
+**/
+void ParallelAStarSearch::run(std::size_t index)
+{
+    Worker &worker = *workers_[index];
+
+    while (true)
+    {
+        // Queue the received supernodes. Duplicates of known states are dropped here,
+        // as the states owned by this worker are only seen by this worker.
+        worker.received.clear();
+        worker.mailbox.takeAll(worker.received);
+        for (auto node : worker.received)
+        {
+            if (node->data_.f_score >= incumbent_cost_.load(std::memory_order_relaxed) ||
+                !worker.transpositions.insert(node, worker.statistics))
+            {
+                release();
+                continue;
+            }
+            worker.open.push(node);
+            worker.statistics.queued++;
+        }
+
+        worker.statistics.peak_open = std::max(worker.statistics.peak_open, worker.open.size());
+        if (worker.open.empty())
+        {
+            if (work_.load(std::memory_order_acquire) == 0)
+                break;
+
+            // Sleep until a supernode arrives or the search ends.
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.sleeping = true;
+            worker.wakeup.wait(lock, [this, &worker] { return !worker.mailbox.empty() || work_.load() == 0; });
+            worker.sleeping = false;
+            continue;
+        }
+
+        Node *current = worker.open.top();
+        worker.open.pop();
+
+        // Skip supernodes replaced by a better one for the same state, or which can not improve the incumbent.
+        if (worker.transpositions.find(current) != current ||
+            current->data_.f_score >= incumbent_cost_.load(std::memory_order_relaxed))
+        {
+            release();
+            continue;
+        }
+
+        if (current->data_.isGoal())
+        {
+            updateIncumbent(current);
+            release();
+            continue;
+        }
+
+        worker.expander.expandNode(current);
+        current->data_.marked = true;
+        worker.statistics.expansions++;
+        worker.statistics.generated += current->numberOfSuccessors();
+
+        for (auto edge : current->successors())
+        {
+            Node *child = edge->getDestination();
+            child->data_.g_score = current->data_.g_score + edge->data_.cost;
+            calcHScore(child);
+            child->data_.calc_fscore();
+
+            if (child->data_.f_score < incumbent_cost_.load(std::memory_order_relaxed))
+                send(child);
+        }
+
+        // The children are accounted for, the expanded supernode is done.
+        release();
+    }
+}
+
+/* Send a supernode to the worker owning its state.
+    @node: supernode with valid g_score and f_score.
+**/
+void ParallelAStarSearch::send(Node *node)
+{
+    work_.fetch_add(1, std::memory_order_acq_rel);
+    Worker &owner = *workers_[node->data_.state.hash() % workers_.size()];
+    owner.mailbox.push(node);
+    if (owner.sleeping.load())
+        wake(owner);
+}
+
+/* Mark a supernode as done. The last one ends the search and wakes all sleeping workers.
+**/
+void ParallelAStarSearch::release()
+{
+    if (work_.fetch_sub(1) != 1)
+        return;
+    for (auto &worker : workers_)
+        wake(*worker);
+}
+
+/* Wake a worker sleeping without work.
+    The mutex orders the notification after the check of the sleeping worker, so it is not lost.
+**/
+void ParallelAStarSearch::wake(Worker &worker)
+{
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+    }
+    worker.wakeup.notify_one();
+}
+
+/* Replace the incumbent if the given goal is cheaper.
+    @goal: goal supernode.
+**/
+void ParallelAStarSearch::updateIncumbent(Node *goal)
+{
+    std::lock_guard<std::mutex> lock(incumbent_mutex_);
+    if (goal->data_.g_score < incumbent_cost_.load())
+    {
+        incumbent_ = goal;
+        incumbent_cost_.store(goal->data_.g_score);
+    }
+}
+
+/* Calculate the h_score of a supernode which is not expanded yet.
+**/
+void ParallelAStarSearch::calcHScore(Node *node)
+{
+    node->data_.h_score = heuristic_ ? (*heuristic_)(node->data_) : 0;
+}
+
+/* Get the peak arena usage, summed over all workers.
+**/
+std::size_t ParallelAStarSearch::arenaPeak() const
+{
+    std::size_t sum = 0;
+    for (auto &worker : workers_)
+        sum += worker->arena.peak();
+    return sum;
+}
+
+/* Get the counters of the expanders, summed over all workers.
+**/
+ExpansionStatistics ParallelAStarSearch::expansionStatistics() const
+{
+    ExpansionStatistics sum;
+    for (auto &worker : workers_)
+    {
+        sum.assignments += worker->expander.statistics().assignments;
+        sum.interactions += worker->expander.statistics().interactions;
+        sum.interactions_reused += worker->expander.statistics().interactions_reused;
+        sum.pruned += worker->expander.statistics().pruned;
+    }
+    return sum;
+}
+
+/* Get the counters collected during the last search, summed over all workers.
+    The peaks of the open-sets are summed as well, which is an upper bound of the peak of all open-sets together.
+**/
+SearchStatistics ParallelAStarSearch::statistics() const
+{
+    SearchStatistics sum;
+    for (auto &worker : workers_)
+    {
+        sum.expansions += worker->statistics.expansions;
+        sum.generated += worker->statistics.generated;
+        sum.queued += worker->statistics.queued;
+        sum.duplicates += worker->statistics.duplicates;
+        sum.peak_open += worker->statistics.peak_open;
+    }
+    return sum;
+}
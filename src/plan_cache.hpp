@@ -0,0 +1,449 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <stdexcept>
+#include <new>
+#include <thread>
+#include <functional>
+#include <unistd.h>
+
+#include "graph.hpp"
+#include "task.hpp"
+#include "compiled_configuration.hpp"
+
+/* 64-bit FNV-1a hash. Used for the keys of the PlanCache.
+**/
+class Fnv1a
+{
+public:
+    void add(const void *, std::size_t);
+    void add(const std::string &);
+    void add(std::uint64_t);
+    void add(double);
+
+    std::uint64_t value() const;
+
+private:
+    std::uint64_t hash_ = 14695981039346656037ull;
+};
+
+/* Counters of a PlanCache since its construction.
+**/
+struct PlanCacheStatistics
+{
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t stores = 0;
+    std::size_t evictions = 0;
+};
+
+/* Persistent cache of solved plans.
+    The key is a hash of the And/Or graph, the costs, the reachability, the agents and the search options.
+    The graph is hashed by the names of its nodes and edges, so the key does not depend on the order of the XML input.
+    Every plan is stored in its own file <key>.plan inside the cache directory in a compact binary format:
+        magic "MSRMPLAN", format version, key, search cost, number of steps,
+        per step the number of tasks, per task action name, agent name and cost.
+    Integers and doubles are written in the byte order of the host.
+    The modification time of a file is its last use. If more than the allowed number of plans are stored,
+    the least recently used ones are deleted.
+    Failing reads and writes are reported, but never abort the planning. A broken file is treated as a miss.
+**/
+class PlanCache
+{
+public:
+    // Constructor
+    PlanCache(const std::string &, std::size_t = 100);
+
+    // Compute the key of a planning request.
+    static std::uint64_t key(Graph<> *, config::CompiledConfiguration *, const config::SearchOptions &);
+
+    // Load a plan. Returns false on a miss.
+    bool load(std::uint64_t, std::vector<std::vector<Task *>> &, double &);
+
+    // Store a solved plan and evict the least recently used plans.
+    bool store(std::uint64_t, const std::vector<std::vector<Task *>> &, double);
+
+    const PlanCacheStatistics &statistics() const;
+
+private:
+    std::filesystem::path path(std::uint64_t) const;
+    void evict();
+
+    std::filesystem::path directory_;
+    std::size_t max_entries_;
+    PlanCacheStatistics statistics_;
+};
+
+// Format of the cache files. Files of another version are ignored.
+constexpr char PLAN_CACHE_MAGIC[8] = {'M', 'S', 'R', 'M', 'P', 'L', 'A', 'N'};
+constexpr std::uint32_t PLAN_CACHE_VERSION = 1;
+
+inline void
+Fnv1a::add(const void *data, std::size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < size; i++)
+    {
+        hash_ ^= bytes[i];
+        hash_ *= 1099511628211ull;
+    }
+}
+
+/* Add a string. The length is added first, so concatenated strings are distinguished.
+**/
+inline void
+Fnv1a::add(const std::string &text)
+{
+    add(std::uint64_t(text.size()));
+    add(text.data(), text.size());
+}
+
+inline void
+Fnv1a::add(std::uint64_t value)
+{
+    add(&value, sizeof(value));
+}
+
+inline void
+Fnv1a::add(double value)
+{
+    add(&value, sizeof(value));
+}
+
+inline std::uint64_t
+Fnv1a::value() const
+{
+    return hash_;
+}
+
+/* Constructor. Creates the cache directory if necessary.
+    @directory: directory of the cache files.
+    @max_entries: maximum number of stored plans. At least one.
+**/
+PlanCache::PlanCache(const std::string &directory, std::size_t max_entries)
+{
+    directory_ = directory;
+    max_entries_ = std::max<std::size_t>(max_entries, 1);
+
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error)
+        std::cerr << "Plan cache: unable to create " << directory_ << ": " << error.message() << std::endl;
+}
+
+/* Compute the key of a planning request.
+    Nodes, actions, subassemblies and agents are visited in the order of their names.
+    @graph: original And/Or graph.
+    @config: compiled configuration with the cost and reach tables.
+    @options: options of the search. They select the algorithm and therefore the plan.
+    \return: 64-bit FNV-1a hash.
+**/
+std::uint64_t PlanCache::key(Graph<> *graph, config::CompiledConfiguration *config, const config::SearchOptions &options)
+{
+    Fnv1a hash;
+    hash.add(std::uint64_t(PLAN_CACHE_VERSION));
+
+    // And/Or graph. Every node with its type and the sorted names of its successors.
+    std::vector<Node *> nodes;
+    for (std::size_t id = 0; id < graph->numberOfNodes(); id++)
+        nodes.push_back(graph->getNode(id));
+    std::sort(nodes.begin(), nodes.end(),
+              [](const Node *lhs, const Node *rhs) { return lhs->data_.name < rhs->data_.name; });
+
+    std::vector<std::string> names;
+    hash.add(std::uint64_t(nodes.size()));
+    for (auto node : nodes)
+    {
+        hash.add(node->data_.name);
+        hash.add(std::uint64_t(node->data_.type == NodeType::AND));
+        names.clear();
+        for (auto successor : node->successorNodes())
+            names.push_back(successor->data_.name);
+        std::sort(names.begin(), names.end());
+        hash.add(std::uint64_t(names.size()));
+        for (auto &name : names)
+            hash.add(name);
+    }
+    hash.add(graph->root_ ? graph->root_->data_.name : std::string());
+
+    // Agents are interned in the order of their names. Hostnames and ports do not change the plan.
+    hash.add(std::uint64_t(config->numberOfAgents()));
+    for (std::size_t agent = 0; agent < config->numberOfAgents(); agent++)
+        hash.add(config->agentName(agent));
+
+    // Cost table.
+    std::vector<std::size_t> ids;
+    for (std::size_t action = 0; action < config->numberOfActions(); action++)
+        ids.push_back(action);
+    std::sort(ids.begin(), ids.end(),
+              [config](std::size_t lhs, std::size_t rhs) { return config->actionName(lhs) < config->actionName(rhs); });
+    hash.add(std::uint64_t(ids.size()));
+    for (auto action : ids)
+    {
+        hash.add(config->actionName(action));
+        for (std::size_t agent = 0; agent < config->numberOfAgents(); agent++)
+            hash.add(config->cost(action, agent));
+    }
+
+    // Reach table. The interaction only matters if the subassembly is not reachable.
+    ids.clear();
+    for (std::size_t subassembly = 0; subassembly < config->numberOfSubassemblies(); subassembly++)
+        ids.push_back(subassembly);
+    std::sort(ids.begin(), ids.end(),
+              [config](std::size_t lhs, std::size_t rhs) { return config->subassemblyName(lhs) < config->subassemblyName(rhs); });
+    hash.add(std::uint64_t(ids.size()));
+    for (auto subassembly : ids)
+    {
+        hash.add(config->subassemblyName(subassembly));
+        for (std::size_t agent = 0; agent < config->numberOfAgents(); agent++)
+        {
+            bool reachable = config->reachable(subassembly, agent);
+            hash.add(std::uint64_t(reachable));
+            if (!reachable)
+                hash.add(config->actionName(config->interaction(subassembly, agent)));
+        }
+    }
+
+    // Search options. The number of threads does not change the plan. The limits and the deadline only decide if a
+    // plan is found in time, and only solved plans with an optimal bound are stored.
+    // Lazy and partial expansion only change the A* search.
+    bool astar = !options.anytime && options.node_budget == 0 && options.beam_width == 0 && !options.greedy;
+    hash.add(std::uint64_t(astar && options.lazy_expansion));
+    hash.add(std::uint64_t(astar && options.partial_expansion));
+    hash.add(std::uint64_t(options.legacy_heuristic));
+    hash.add(std::uint64_t(options.anytime));
+    hash.add(options.initial_epsilon);
+    hash.add(options.epsilon_step);
+    hash.add(std::uint64_t(options.node_budget));
+    hash.add(std::uint64_t(options.beam_width));
+    hash.add(std::uint64_t(options.greedy));
+    hash.add(std::uint64_t(options.greedy_open_limit));
+    hash.add(std::uint64_t(options.seed_incumbent));
+
+    return hash.value();
+}
+
+/* Read a value of the cache file format.
+**/
+template <typename T>
+inline bool
+readValue(std::istream &file, T &value)
+{
+    return bool(file.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+/* Read a string of the cache file format.
+    The length is checked against the rest of the file first, so a broken length does not allocate.
+    @file_size: size of the whole file in bytes.
+**/
+inline bool
+readString(std::istream &file, std::uint64_t file_size, std::string &text)
+{
+    std::uint32_t size;
+    if (!readValue(file, size))
+        return false;
+    std::streamoff position = file.tellg();
+    if (position < 0 || size > file_size - std::uint64_t(position))
+        return false;
+    text.resize(size);
+    return bool(file.read(&text[0], size));
+}
+
+template <typename T>
+inline void
+writeValue(std::ostream &file, const T &value)
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+inline void
+writeString(std::ostream &file, const std::string &text)
+{
+    writeValue(file, std::uint32_t(text.size()));
+    file.write(text.data(), text.size());
+}
+
+/* Load a plan from the cache. A hit marks the plan as recently used.
+    @key: key of the request.
+    @plan: filled with the cached plan. The tasks are owned by the caller.
+    @search_cost: set to the search cost of the cached plan.
+    \return: true on a hit.
+**/
+bool PlanCache::load(std::uint64_t key, std::vector<std::vector<Task *>> &plan, double &search_cost)
+{
+    std::filesystem::path file_path = path(key);
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file)
+    {
+        statistics_.misses++;
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    std::uint64_t file_size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    char magic[sizeof(PLAN_CACHE_MAGIC)];
+    std::uint32_t version;
+    std::uint64_t stored_key;
+    std::uint32_t n_steps;
+    bool valid = file.read(magic, sizeof(magic)) &&
+                 std::memcmp(magic, PLAN_CACHE_MAGIC, sizeof(magic)) == 0 &&
+                 readValue(file, version) && version == PLAN_CACHE_VERSION &&
+                 readValue(file, stored_key) && stored_key == key &&
+                 readValue(file, search_cost) &&
+                 readValue(file, n_steps);
+
+    // A broken file must not end the planner. Failed allocations count as a broken file as well.
+    std::vector<std::vector<Task *>> loaded;
+    try
+    {
+        for (std::uint32_t step = 0; valid && step < n_steps; step++)
+        {
+            std::uint32_t n_tasks;
+            valid = readValue(file, n_tasks);
+            loaded.emplace_back();
+            for (std::uint32_t task = 0; valid && task < n_tasks; task++)
+            {
+                std::string action, agent;
+                double cost;
+                valid = readString(file, file_size, action) && readString(file, file_size, agent) && readValue(file, cost);
+                if (valid)
+                    loaded.back().push_back(new Task(action, agent, cost));
+            }
+        }
+    }
+    catch (const std::bad_alloc &)
+    {
+        valid = false;
+    }
+    catch (const std::length_error &)
+    {
+        valid = false;
+    }
+
+    if (!valid)
+    {
+        std::cerr << "Plan cache: " << file_path << " is broken and is removed." << std::endl;
+        for (auto &step : loaded)
+            for (auto task : step)
+                delete task;
+        file.close();
+        std::error_code error;
+        std::filesystem::remove(file_path, error);
+        statistics_.misses++;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::last_write_time(file_path, std::filesystem::file_time_type::clock::now(), error);
+    plan.swap(loaded);
+    statistics_.hits++;
+    return true;
+}
+
+/* Store a solved plan. The file is written under a temporary name and renamed,
+    so concurrent planners never read a partial file. The temporary name contains the process and thread id,
+    so concurrent planners storing the same key never write into the same file.
+    @key: key of the request.
+    @plan: plan in the order of the execution.
+    @search_cost: search cost of the plan.
+    \return: false if the plan could not be written.
+**/
+bool PlanCache::store(std::uint64_t key, const std::vector<std::vector<Task *>> &plan, double search_cost)
+{
+    std::filesystem::path file_path = path(key);
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".%ld.%zx.tmp", static_cast<long>(getpid()),
+             std::hash<std::thread::id>()(std::this_thread::get_id()));
+    std::filesystem::path temporary = file_path;
+    temporary += suffix;
+    bool written;
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(PLAN_CACHE_MAGIC, sizeof(PLAN_CACHE_MAGIC));
+        writeValue(file, PLAN_CACHE_VERSION);
+        writeValue(file, key);
+        writeValue(file, search_cost);
+        writeValue(file, std::uint32_t(plan.size()));
+        for (auto &step : plan)
+        {
+            writeValue(file, std::uint32_t(step.size()));
+            for (auto task : step)
+            {
+                writeString(file, task->action_);
+                writeString(file, task->agent_);
+                writeValue(file, task->cost_);
+            }
+        }
+        file.close();
+        written = !file.fail();
+    }
+
+    std::error_code error;
+    if (!written)
+    {
+        std::cerr << "Plan cache: unable to write " << temporary << "." << std::endl;
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    std::filesystem::rename(temporary, file_path, error);
+    if (error)
+    {
+        std::cerr << "Plan cache: unable to write " << file_path << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    statistics_.stores++;
+    evict();
+    return true;
+}
+
+/* Delete the least recently used plans until at most max_entries_ are stored.
+**/
+void PlanCache::evict()
+{
+    std::error_code error;
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> entries;
+    for (auto &entry : std::filesystem::directory_iterator(directory_, error))
+    {
+        if (entry.path().extension() != ".plan")
+            continue;
+        auto time = entry.last_write_time(error);
+        if (!error)
+            entries.emplace_back(time, entry.path());
+    }
+    if (entries.size() <= max_entries_)
+        return;
+
+    std::sort(entries.begin(), entries.end());
+    for (std::size_t i = 0; i + max_entries_ < entries.size(); i++)
+    {
+        if (std::filesystem::remove(entries[i].second, error))
+            statistics_.evictions++;
+    }
+}
+
+/* File of a cached plan.
+**/
+std::filesystem::path PlanCache::path(std::uint64_t key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.plan", static_cast<unsigned long long>(key));
+    return directory_ / name;
+}
+
+/* Get the counters since the construction of the cache.
+**/
+const PlanCacheStatistics &PlanCache::statistics() const
+{
+    return statistics_;
+}
@@ -1,10 +1,41 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <chrono>
 #include <unordered_map>
 #include "dotwriter.hpp"
 #include "astar.hpp"
+#include "parallel_astar.hpp"
+#include "anytime_astar.hpp"
+#include "ida_star.hpp"
+#include "beam_search.hpp"
 #include "task.hpp"
+#include "compiled_configuration.hpp"
+#include "csr_graph.hpp"
+
+/* Summary of the last planning run. Used for the machine-readable report.
+**/
+struct PlanningStatistics
+{
+    // Search algorithm selected by the options.
+    std::string mode;
+    SearchStatistics search;
+    ExpansionStatistics expansion;
+    // Peak memory of the supernodes and edges in bytes. Zero if they are not placed inside an arena.
+    std::size_t arena_peak = 0;
+    // Wall time of the search without building the snapshot and backtracking the plan, in milliseconds.
+    double search_time = 0;
+    bool solved = false;
+    // Outcome of the search. A partial plan is returned unless it is "solved".
+    std::string status;
+    // Suboptimality bound of the plan. Only the anytime search returns plans above 1 that depend on its deadline.
+    double bound = 1;
+    // Objective of the search (sum of the average step costs) and sum of the action costs of the plan.
+    double search_cost = 0;
+    double plan_cost = 0;
+    std::size_t plan_steps = 0;
+};
 
 /* Planner Class. 
     Used as a Top_Level supervisor for the planning process.
@@ -13,48 +44,193 @@
 class Planner
 {
 public:
+    Planner(config::SearchOptions = config::SearchOptions());
+
     // Start Planning
-    std::vector< std::vector<Task*>> operator()(Graph<> *, Node *, config::Configuration * );
+    std::vector< std::vector<Task*>> operator()(Graph<> *, Node *, config::CompiledConfiguration * );
+
+    // Counters and timings of the last call.
+    const PlanningStatistics &statistics() const;
 
 private:
+    Node *insertRoot(Graph<> *, Node *);
+
     // Container used to track the resulting optimal assembly sequence.
     // Vector of Tuples containing <action_pointer, agent_name, cost>
     std::vector<std::vector<Task*>> assembly_plan_;
     Graph<> *search_graph;
+
+    // Memory of the supernodes and edges of the search_graph. Released at once after the search.
+    Arena search_arena_;
+
+    config::SearchOptions options_;
+    PlanningStatistics statistics_;
 };
 
+/* Constructor.
+    @options: options selecting the behavior of the search.
+**/
+Planner::Planner(config::SearchOptions options)
+{
+    options_ = options;
+}
+
+/* Insert the first supernode of a search.
+    @search_graph: graph of supernodes.
+    @root: root of the original A/O graph.
+    \return: supernode containing the root as its only subassembly.
+**/
+Node *Planner::insertRoot(Graph<> *search_graph, Node *root)
+{
+    Node *new_root = search_graph->insertNode(root->data_);
+
+    // Set the subassemblies and actions of the first supernode.
+    // The actions correspond to all possible moves we can take in the first supernode.
+    new_root->data_.state.addSubassembly(root->id_);
+    for (auto x : root->successorNodes())
+    {
+        new_root->data_.state.addAction(x->id_);
+    }
+    return new_root;
+}
+
 /* Start Plannning.
     @graph: pointer to the original A/O graph obtained from the InputReader
     @root: pointer to the node the search should start at.
-    @config: configuration contianing the cost_map and reachability_map.
+    @config: compiled configuration contianing the cost_map and reachability_map.
     \return: vector containing the assembly plan
 **/
 std::vector< std::vector<Task*>> 
-Planner::operator()(Graph<> *graph, Node *root, config::Configuration * config)
+Planner::operator()(Graph<> *graph, Node *root, config::CompiledConfiguration * config)
 {
     // Create a new Graph.
     // It is a different Graph the the one passed as a function parameter.
     // This one is the graph of Hypernodes used later for the A* search.
-    search_graph = new Graph<>();
-    Node *new_root = search_graph->insertNode(root->data_);
-
-    // Set the subassemblies and actions of the first supernode.
-    // The actions correspond to all possible moves we can take in the first supernode.
-    new_root->data_.subassemblies[root->data_.name] = root;
-    for (auto &x : root->getSuccessorNodes())
+    // The supernodes refer to the nodes of the original graph by their id inside a SearchState.
+    if (graph->numberOfNodes() > SearchState::capacity)
     {
-        new_root->data_.actions[x->data_.name] = x;
+        std::cerr << "Graph has " << graph->numberOfNodes() << " nodes. "
+                  << "Only " << SearchState::capacity << " are supported. "
+                  << "Increase SEARCH_STATE_MAX_NODES." << std::endl;
+        throw std::range_error("Graph too large.");
     }
 
+    // The memory-bounded search erases supernodes during the search, so their memory has to be freed one by one.
+    search_graph = options_.node_budget > 0 ? new Graph<>() : new Graph<>(&search_arena_);
+    Node *new_root = insertRoot(search_graph, root);
+
     // Create the NodeExpander and pass it to the AStarSearch.
     // The AStarSearch uses the received Expander later during the search.
     // If a different expansion-behavior is desired, just modify the exapnder,
     // obeying to the interface used by the AStarSearch.
-    NodeExpander *expander = new NodeExpander(search_graph, config);
+    // The original graph does not change during the search. The expander and the heuristic
+    // traverse a contiguous snapshot of it.
+    CsrGraph original(graph);
+    NodeExpander *expander = new NodeExpander(search_graph, config, &original);
+
+    // Wide supernodes are expanded by several threads.
+    std::unique_ptr<ThreadPool> expansion_pool;
+    if (options_.expansion_threads > 1)
+    {
+        expansion_pool.reset(new ThreadPool(options_.expansion_threads));
+        expander->setThreadPool(expansion_pool.get());
+    }
+
+    // Lower bounds of the subassemblies, computed once on the original graph.
+    Heuristic heuristic(&original, config);
 
     // AStarSearch algorithm
-    AStarSearch astar;
-    Node *result = astar.search(search_graph, new_root, expander);
+    // With more than one thread, the parallel search creates its own expanders and graphs.
+    // They have to live until the plan has been backtracked.
+    AStarSearch astar(options_, options_.legacy_heuristic ? nullptr : &heuristic);
+    std::unique_ptr<ParallelAStarSearch> parallel;
+    Node *result;
+    std::size_t arena_peak = 0;
+    statistics_ = PlanningStatistics();
+    auto search_start = std::chrono::steady_clock::now();
+    if (options_.greedy || options_.beam_width > 0)
+    {
+        // The greedy search is guided by the heuristic alone, the legacy one is not known before the expansion.
+        if (options_.greedy)
+        {
+            GreedySearch greedy(options_, &heuristic);
+            result = greedy.search(search_graph, new_root, expander);
+            statistics_.search = greedy.statistics();
+            statistics_.mode = "greedy";
+        }
+        else
+        {
+            BeamSearch beam(options_, &heuristic);
+            result = beam.search(search_graph, new_root, expander);
+            statistics_.search = beam.statistics();
+            statistics_.mode = "beam";
+        }
+    }
+    else if (options_.node_budget > 0)
+    {
+        IDAStarSearch ida(options_, &heuristic);
+        result = ida.search(search_graph, new_root, expander);
+        statistics_.search = ida.statistics();
+        statistics_.status = toString(ida.status());
+        statistics_.mode = "ida";
+        std::cout << "Iterations: " << ida.iterations()
+                  << "  Peak supernodes: " << ida.peakNodes() << std::endl;
+    }
+    else if (options_.anytime)
+    {
+        // Every improved plan is reported as soon as it is found. The last one is backtracked below.
+        AnytimeAStarSearch anytime(options_, &heuristic);
+        result = anytime.search(search_graph, new_root, expander, [](Node *goal, double bound) {
+            std::cout << "Plan found. Search cost: " << goal->data_.g_score
+                      << "  Suboptimality bound: " << bound << std::endl;
+        });
+        statistics_.search = anytime.statistics();
+        statistics_.bound = anytime.publishedBound();
+        statistics_.mode = "anytime";
+    }
+    else if (options_.threads > 1)
+    {
+        parallel.reset(new ParallelAStarSearch(options_.threads, config, &original, &heuristic));
+        result = parallel->search(new_root);
+        statistics_.search = parallel->statistics();
+        statistics_.expansion = parallel->expansionStatistics();
+        statistics_.mode = "parallel";
+        arena_peak = parallel->arenaPeak();
+    }
+    else
+    {
+        result = astar.search(search_graph, new_root, expander);
+        statistics_.search = astar.statistics();
+        statistics_.status = toString(astar.status());
+        statistics_.mode = options_.partial_expansion ? "partial" : options_.lazy_expansion ? "lazy" : "astar";
+    }
+    statistics_.search_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - search_start).count();
+    if (!parallel)
+        statistics_.expansion = expander->statistics();
+    arena_peak += search_arena_.peak();
+    statistics_.arena_peak = arena_peak;
+    statistics_.solved = result->data_.isGoal();
+    if (statistics_.status.empty())
+        statistics_.status = toString(statistics_.solved ? SearchStatus::Solved : SearchStatus::Exhausted);
+    statistics_.search_cost = result->data_.g_score;
+
+    // The reference search runs on its own search graph and expander. The supernodes of the beam or greedy search
+    // are already expanded, searching them again would create their successors a second time.
+    if ((options_.greedy || options_.beam_width > 0) && !statistics_.solved)
+    {
+        std::cout << "No plan found. Increase the " << (options_.greedy ? "open-set limit." : "beam width.") << std::endl;
+    }
+    else if ((options_.greedy || options_.beam_width > 0) && options_.report_gap)
+    {
+        double found = result->data_.g_score;
+        Arena reference_arena;
+        Graph<> reference_graph(&reference_arena);
+        NodeExpander reference_expander(&reference_graph, config, &original);
+        AStarSearch reference(config::SearchOptions(), &heuristic);
+        double optimal = reference.search(&reference_graph, insertRoot(&reference_graph, root), &reference_expander)->data_.g_score;
+        std::cout << "Search cost: " << found << "  Optimal: " << optimal
+                  << "  Gap: " << (optimal > 0 ? 100 * (found - optimal) / optimal : 0) << " %" << std::endl;
+    }
 
     // Container used to represent the found agent-action assignement and its cost in a current step.
     // Vector of Tuples containing <action_pointer, agent_name, cost>
@@ -67,11 +243,11 @@ Planner::operator()(Graph<> *graph, Node *root, config::Configuration * config)
     double cost = 0;
     while (result->hasPredecessor())
     {
-        for (auto &i : result->getPredecessors().front()->data_.agent_actions_)
+        for (auto &i : result->predecessors().front()->data_.agent_actions_)
         {
             std::string action_name = i.first->data_.name;
             std::string agent_name = i.second;
-            double cur_cost = config->actions[action_name].costs[agent_name];
+            double cur_cost = config->cost(i.first->data_.config_index, config->agentId(agent_name));
 
             std::cout << "Action: " << action_name << " Agent: " << agent_name << "    ";
             cost += cur_cost;
@@ -81,14 +257,36 @@ Planner::operator()(Graph<> *graph, Node *root, config::Configuration * config)
         assembly_plan_.push_back(optimum);
         optimum.clear();
         std::cout << std::endl;
-        result = result->getPredecessorNodes().front();
+        result = result->predecessors().front()->getSource();
     }
 
-    std::cout << "Cost: " << cost << std::endl << std::endl;
+    statistics_.plan_cost = cost;
+    statistics_.plan_steps = assembly_plan_.size();
+
+    if (!statistics_.solved)
+    {
+        std::cout << "PARTIAL PLAN. Search stopped: " << statistics_.status << ". "
+                  << "The plan covers " << assembly_plan_.size() << " steps and does not complete the assembly." << std::endl;
+    }
+    std::cout << "Cost: " << cost << std::endl;
+    std::cout << "Expansions: " << statistics_.search.expansions
+              << "  Generated: " << statistics_.search.generated
+              << "  Queued: " << statistics_.search.queued
+              << "  Duplicates pruned: " << statistics_.search.duplicates << std::endl;
+    std::cout << "Arena peak: " << arena_peak / 1024 << " KiB" << std::endl << std::endl;
     std::cout << "- - - -  - - - -  - - - -  - - - -  - - - -  - - - - " << std::endl << std::endl;
 
+    parallel.reset();
     delete search_graph;
     delete expander;
+    search_arena_.release();
 
     return assembly_plan_;
 }
+
+/* Get the counters and timings of the last planning run.
+**/
+const PlanningStatistics &Planner::statistics() const
+{
+    return statistics_;
+}
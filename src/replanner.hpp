@@ -0,0 +1,656 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+#include "astar.hpp"
+#include "heuristic.hpp"
+#include "indexed_heap.hpp"
+#include "task.hpp"
+#include "compiled_configuration.hpp"
+#include "csr_graph.hpp"
+
+/* Change of the configuration observed during the execution of a plan.
+    Ids refer to the config::CompiledConfiguration.
+**/
+struct ConfigurationDelta
+{
+    struct Cost
+    {
+        std::size_t action;
+        std::size_t agent;
+        double cost;
+    };
+
+    struct Reach
+    {
+        std::size_t subassembly;
+        std::size_t agent;
+        bool reachable;
+        // Interaction-action needed if the subassembly is not reachable.
+        std::size_t interaction;
+    };
+
+    std::vector<Cost> costs;
+    std::vector<Reach> reachability;
+};
+
+/* Comparator of the Replanner.
+    Orders the supernodes by the key of Lifelong Planning A*, which is stored as (f_score, g_score).
+**/
+struct LessKey
+{
+    bool operator()(const Node *lhs, const Node *rhs) const
+    {
+        if (lhs->data_.f_score != rhs->data_.f_score)
+            return lhs->data_.f_score > rhs->data_.f_score;
+        return lhs->data_.g_score > rhs->data_.g_score;
+    }
+};
+
+/* Incremental replanning with Lifelong Planning A* (LPA*).
+    The search runs from the complete assembly towards its parts, the plan is executed in reverse.
+    Every executed step therefore moves the target of the search closer to the root, while the root stays fixed.
+    The g-values (costs from the root) stay valid when the target moves. Only the keys of the open-set change.
+    The Replanner keeps the search graph between the calls. Every state is represented by one supernode (vertex),
+    its expansion is stored as transitions to the vertices of the successor states.
+        rhs: one-step lookahead of the g-value, the minimum of g + cost over the predecessors.
+        A vertex is consistent if g == rhs. Inconsistent vertices are queued with the key
+        [min(g, rhs) + h, min(g, rhs)].
+    A change of the costs updates the cost of the stored transitions, a change of the reachability expands the
+    affected vertices again. If interchangeable agents become distinct, all expanded vertices are expanded again.
+    Only the vertices whose rhs changed are queued, the rest of the search is reused.
+    The heuristic towards an intermediate target is the difference of the summed lower bounds, which is consistent.
+**/
+class Replanner
+{
+public:
+    Replanner(Graph<> *, Node *, config::CompiledConfiguration *);
+    ~Replanner();
+
+    // Plan from the root to the goal. Can only be called once.
+    std::vector<std::vector<Task *>> plan();
+
+    // Apply a change of the configuration and plan the steps which are not executed yet.
+    std::vector<std::vector<Task *>> replan(const ConfigurationDelta &, std::size_t);
+
+    // Counters of the last call.
+    const SearchStatistics &statistics() const;
+
+    // Search cost of the last plan. INFINITY if no plan was found.
+    double cost() const;
+
+    // State the last search ended at. The goal for the first plan and the executed state afterwards.
+    // nullptr if no goal has been reached yet.
+    const SearchState *target() const;
+
+private:
+    struct Transition
+    {
+        Edge *edge;
+        std::size_t target;
+    };
+
+    struct Link
+    {
+        std::size_t source;
+        Edge *edge;
+    };
+
+    struct Vertex
+    {
+        Node *node;
+        double g;
+        double rhs;
+        // Summed lower bound of the remaining subassemblies and full heuristic towards the goal.
+        double total;
+        double h_goal;
+        bool expanded;
+        bool goal;
+        std::vector<Transition> successors;
+        std::vector<Link> predecessors;
+    };
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::size_t vertex(Node *);
+    void expand(std::size_t);
+    void updateVertex(std::size_t);
+    void queue(std::size_t);
+    void setKey(std::size_t);
+    double heuristic(std::size_t) const;
+    bool less(double, double, double, double) const;
+    void rekey();
+    void applyDelta(const ConfigurationDelta &);
+    void expandAgain(std::size_t, std::vector<std::size_t> &);
+    bool affected(const Transition &, const ConfigurationDelta::Reach &) const;
+    double stepCost(const Edge *) const;
+    void computePath();
+    std::vector<std::vector<Task *>> backtrack();
+
+    config::CompiledConfiguration *config_;
+    CsrGraph original_;
+
+    // Search graph. Supernodes are never erased, the memory is released with the Replanner.
+    Arena arena_;
+    Graph<> *search_graph_;
+    NodeExpander *expander_;
+    std::unique_ptr<Heuristic> heuristic_;
+    double n_agents_;
+
+    // Vertices indexed by their creation order. A deque keeps references valid while vertices are added.
+    std::deque<Vertex> vertices_;
+    // Hash of the SearchState -> vertex.
+    std::unordered_multimap<std::size_t, std::size_t> states_;
+    std::unordered_map<const Node *, std::size_t> vertex_ids_;
+    IndexedHeap<LessKey> open_;
+
+    // The root is vertex 0. The target is the goal for the first plan and the executed state afterwards.
+    std::size_t goal_;
+    std::size_t target_;
+    bool planned_;
+
+    // Vertices from the root to the target of the last plan.
+    std::vector<std::size_t> path_;
+
+    SearchStatistics statistics_;
+};
+
+/* Constructor. Creates the search graph with the root supernode.
+    @graph: original And/Or graph obtained from the InputReader.
+    @root: node of the complete assembly.
+    @config: compiled configuration. Changed by replan, the Replanner has to be its only user.
+**/
+Replanner::Replanner(Graph<> *graph, Node *root, config::CompiledConfiguration *config)
+    : original_(graph)
+{
+    if (graph->numberOfNodes() > SearchState::capacity)
+    {
+        std::cerr << "Graph has " << graph->numberOfNodes() << " nodes. "
+                  << "Only " << SearchState::capacity << " are supported. "
+                  << "Increase SEARCH_STATE_MAX_NODES." << std::endl;
+        throw std::range_error("Graph too large.");
+    }
+
+    config_ = config;
+    search_graph_ = new Graph<>(&arena_);
+    expander_ = new NodeExpander(search_graph_, config_, &original_);
+    // Transitions discarded for a cheaper one could become optimal after a cost change.
+    expander_->setDominancePruning(false);
+    heuristic_.reset(new Heuristic(&original_, config_));
+    n_agents_ = std::max<std::size_t>(config_->numberOfAgents(), 1);
+    goal_ = npos;
+    target_ = npos;
+    planned_ = false;
+
+    Node *new_root = search_graph_->insertNode(root->data_);
+    new_root->data_.state.addSubassembly(root->id_);
+    for (auto x : root->successorNodes())
+    {
+        new_root->data_.state.addAction(x->id_);
+    }
+    vertex(new_root);
+}
+
+/* Destructor
+**/
+Replanner::~Replanner()
+{
+    open_.clear();
+    delete search_graph_;
+    delete expander_;
+}
+
+/* Plan from the root to the goal.
+    \return: assembly plan in the order of the execution. Empty if there is none.
+**/
+std::vector<std::vector<Task *>> Replanner::plan()
+{
+    if (planned_)
+        throw std::logic_error("Replanner::plan can only be called once. Use replan.");
+    planned_ = true;
+    statistics_ = SearchStatistics();
+
+    vertices_[0].rhs = 0;
+    queue(0);
+    computePath();
+    return backtrack();
+}
+
+/* Apply a change of the configuration and plan the steps which are not executed yet.
+    @delta: changed costs and reachability.
+    @executed: number of steps of the last plan which have been executed.
+    \return: remaining assembly plan in the order of the execution. It ends in the complete assembly.
+             Empty if there is none, or if the assembly is complete.
+**/
+std::vector<std::vector<Task *>> Replanner::replan(const ConfigurationDelta &delta, std::size_t executed)
+{
+    if (!planned_ || path_.empty())
+        throw std::logic_error("Replanner::replan needs a previous plan.");
+    if (executed >= path_.size())
+    {
+        std::cerr << "Only " << path_.size() - 1 << " steps of the last plan can be executed, not "
+                  << executed << "." << std::endl;
+        throw std::range_error("Too many executed steps.");
+    }
+    statistics_ = SearchStatistics();
+
+    // The plan is executed in reverse, the first executed step is the last edge of the path.
+    target_ = path_[path_.size() - 1 - executed];
+
+    applyDelta(delta);
+    rekey();
+    computePath();
+    return backtrack();
+}
+
+/* Obtain the vertex of a supernode. Creates a new vertex if its state is not known yet.
+    @node: supernode of the search graph.
+    \return: index of the vertex representing the state of the supernode.
+**/
+std::size_t Replanner::vertex(Node *node)
+{
+    std::size_t hash = node->data_.state.hash();
+    auto range = states_.equal_range(hash);
+    for (auto it = range.first; it != range.second; it++)
+    {
+        if (vertices_[it->second].node->data_.state == node->data_.state)
+        {
+            statistics_.duplicates++;
+            return it->second;
+        }
+    }
+
+    Vertex v;
+    v.node = node;
+    v.g = INFINITY;
+    v.rhs = INFINITY;
+    v.total = heuristic_->total(node->data_);
+    v.h_goal = (*heuristic_)(node->data_);
+    v.expanded = false;
+    v.goal = node->data_.isGoal();
+
+    std::size_t id = vertices_.size();
+    vertices_.push_back(std::move(v));
+    states_.insert(std::make_pair(hash, id));
+    vertex_ids_[node] = id;
+    if (vertices_[id].goal)
+        goal_ = id;
+    return id;
+}
+
+/* Expand a vertex and link it to the vertices of its successor states.
+    Successors of an earlier expansion are left inside the search graph, but are not linked anymore.
+    @u: index of the vertex.
+**/
+void Replanner::expand(std::size_t u)
+{
+    Node *node = vertices_[u].node;
+    std::size_t first = node->numberOfSuccessors();
+    expander_->expandNode(node);
+    statistics_.expansions++;
+    statistics_.generated += node->numberOfSuccessors() - first;
+
+    std::size_t index = 0;
+    for (auto edge : node->successors())
+    {
+        if (index++ < first)
+            continue;
+        std::size_t v = vertex(edge->getDestination());
+        vertices_[u].successors.push_back(Transition{edge, v});
+        vertices_[v].predecessors.push_back(Link{u, edge});
+    }
+    vertices_[u].expanded = true;
+}
+
+/* Recompute the rhs of a vertex from its predecessors and queue it if it is inconsistent.
+    @v: index of the vertex.
+**/
+void Replanner::updateVertex(std::size_t v)
+{
+    Vertex &vertex = vertices_[v];
+    if (v != 0)
+    {
+        vertex.rhs = INFINITY;
+        for (auto &link : vertex.predecessors)
+        {
+            vertex.rhs = std::min(vertex.rhs, vertices_[link.source].g + link.edge->data_.cost);
+        }
+    }
+    queue(v);
+}
+
+/* Insert an inconsistent vertex into the open-set, or update its key. Remove a consistent one.
+    @v: index of the vertex.
+**/
+void Replanner::queue(std::size_t v)
+{
+    Vertex &vertex = vertices_[v];
+    if (vertex.g != vertex.rhs)
+    {
+        setKey(v);
+        if (open_.contains(vertex.node))
+        {
+            open_.update(vertex.node);
+        }
+        else
+        {
+            open_.push(vertex.node);
+            statistics_.queued++;
+            statistics_.peak_open = std::max(statistics_.peak_open, open_.size());
+        }
+    }
+    else if (open_.contains(vertex.node))
+    {
+        open_.remove(vertex.node);
+    }
+}
+
+/* Store the key of a vertex inside its supernode. f_score holds the first, g_score the second component.
+**/
+void Replanner::setKey(std::size_t v)
+{
+    Vertex &vertex = vertices_[v];
+    double k2 = std::min(vertex.g, vertex.rhs);
+    vertex.node->data_.g_score = k2;
+    vertex.node->data_.f_score = k2 + heuristic(v);
+}
+
+/* Lower bound of the cost from a vertex to the current target.
+    Towards the goal the full heuristic is used, towards an executed state the difference of the summed bounds.
+**/
+double Replanner::heuristic(std::size_t v) const
+{
+    if (target_ == npos)
+        return vertices_[v].h_goal;
+    return std::max((vertices_[v].total - vertices_[target_].total) / n_agents_, 0.0);
+}
+
+/* Compare two keys lexicographically.
+    \return: true if key (a1, a2) is lower than key (b1, b2).
+**/
+bool Replanner::less(double a1, double a2, double b1, double b2) const
+{
+    return a1 < b1 || (a1 == b1 && a2 < b2);
+}
+
+/* Recompute the keys of all queued vertices after the target or the heuristic changed.
+**/
+void Replanner::rekey()
+{
+    std::vector<Node *> queued;
+    queued.reserve(open_.size());
+    while (!open_.empty())
+    {
+        queued.push_back(open_.top());
+        open_.pop();
+    }
+    for (auto node : queued)
+    {
+        setKey(vertex_ids_[node]);
+    }
+    open_.pushAll(queued);
+}
+
+/* Change the configuration and repair the stored transitions.
+    Cost changes update the cost of every transition and the heuristic.
+    Reachability changes expand the vertices again whose transitions create the affected subassembly.
+    The vertices at the end of changed transitions are updated.
+**/
+void Replanner::applyDelta(const ConfigurationDelta &delta)
+{
+    std::vector<std::size_t> classes(config_->numberOfAgents());
+    for (std::size_t agent = 0; agent < classes.size(); agent++)
+        classes[agent] = config_->agentClass(agent);
+
+    for (auto &change : delta.costs)
+    {
+        config_->setCost(change.action, change.agent, change.cost);
+    }
+    for (auto &change : delta.reachability)
+    {
+        config_->setReachable(change.subassembly, change.agent, change.reachable, change.interaction);
+    }
+
+    // The expansions only contain one assignment per class of interchangeable agents.
+    // If the classes changed, the stored transitions are incomplete.
+    bool classes_changed = false;
+    for (std::size_t agent = 0; agent < classes.size(); agent++)
+        classes_changed = classes_changed || classes[agent] != config_->agentClass(agent);
+
+    std::vector<std::size_t> changed;
+    if (!delta.reachability.empty() || classes_changed)
+    {
+        // Vertices are added while expanding, only the ones known before can be affected.
+        std::size_t known = vertices_.size();
+        for (std::size_t u = 0; u < known; u++)
+        {
+            bool expand_again = classes_changed && vertices_[u].expanded;
+            for (auto &transition : vertices_[u].successors)
+            {
+                for (auto &change : delta.reachability)
+                {
+                    expand_again = expand_again || affected(transition, change);
+                }
+            }
+            if (expand_again)
+                expandAgain(u, changed);
+        }
+    }
+
+    if (!delta.costs.empty())
+    {
+        heuristic_.reset(new Heuristic(&original_, config_));
+        for (auto &vertex : vertices_)
+        {
+            vertex.total = heuristic_->total(vertex.node->data_);
+            vertex.h_goal = (*heuristic_)(vertex.node->data_);
+            for (auto &transition : vertex.successors)
+            {
+                double cost = stepCost(transition.edge);
+                if (cost == transition.edge->data_.cost)
+                    continue;
+                transition.edge->data_.cost = cost;
+                changed.push_back(transition.target);
+            }
+        }
+    }
+
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    for (auto v : changed)
+    {
+        updateVertex(v);
+    }
+}
+
+/* Replace the transitions of an expanded vertex by a new expansion.
+    @u: index of the vertex.
+    @changed: the targets of the old and the new transitions are appended.
+**/
+void Replanner::expandAgain(std::size_t u, std::vector<std::size_t> &changed)
+{
+    // Unlink the old transitions. Their targets lose a predecessor.
+    for (auto &transition : vertices_[u].successors)
+    {
+        auto &links = vertices_[transition.target].predecessors;
+        links.erase(std::remove_if(links.begin(), links.end(),
+                                   [&](const Link &link) { return link.edge == transition.edge; }),
+                    links.end());
+        changed.push_back(transition.target);
+    }
+    vertices_[u].successors.clear();
+    expand(u);
+    for (auto &transition : vertices_[u].successors)
+    {
+        changed.push_back(transition.target);
+    }
+}
+
+/* Check if a transition creates a subassembly with a changed reachability.
+    The reachability is checked for the parts created by the actions of a step, for the agent executing them.
+**/
+bool Replanner::affected(const Transition &transition, const ConfigurationDelta::Reach &change) const
+{
+    for (auto &agent_action : transition.edge->data_.agent_actions_)
+    {
+        if (config_->agentId(agent_action.second) != change.agent)
+            continue;
+
+        Node *action = agent_action.first;
+        if (original_.contains(action))
+        {
+            for (auto part : original_.successors(action->id_))
+            {
+                if (original_.configIndex(part) == change.subassembly)
+                    return true;
+            }
+        }
+        else if (action->successors().front()->getDestination()->data_.config_index == change.subassembly)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Cost of a transition from the current cost table. The average of the costs of the actions of the step.
+**/
+double Replanner::stepCost(const Edge *edge) const
+{
+    double cost = 0;
+    for (auto &agent_action : edge->data_.agent_actions_)
+    {
+        cost += config_->cost(agent_action.first->data_.config_index, config_->agentId(agent_action.second));
+    }
+    return edge->data_.agent_actions_.empty() ? 0 : cost / edge->data_.agent_actions_.size();
+}
+
+/* Process the inconsistent vertices in the order of their keys until the target is consistent
+    and no queued vertex has a lower key.
+**/
+void Replanner::computePath()
+{
+    while (!open_.empty())
+    {
+        std::size_t target = target_ == npos ? goal_ : target_;
+        Node *top = open_.top();
+        if (target != npos)
+        {
+            Vertex &t = vertices_[target];
+            double k2 = std::min(t.g, t.rhs);
+            if (t.g == t.rhs && !less(top->data_.f_score, top->data_.g_score, k2 + heuristic(target), k2))
+                break;
+        }
+
+        std::size_t u = vertex_ids_[top];
+        open_.pop();
+        if (!vertices_[u].expanded && !vertices_[u].goal)
+            expand(u);
+
+        Vertex &vertex = vertices_[u];
+        if (vertex.g > vertex.rhs)
+        {
+            // Overconsistent. The g-value decreases, the successors can only improve.
+            vertex.g = vertex.rhs;
+            for (auto &transition : vertex.successors)
+            {
+                Vertex &successor = vertices_[transition.target];
+                double rhs = vertex.g + transition.edge->data_.cost;
+                if (transition.target != 0 && rhs < successor.rhs)
+                {
+                    successor.rhs = rhs;
+                    queue(transition.target);
+                }
+            }
+        }
+        else
+        {
+            // Underconsistent. The g-value increased, every vertex depending on it is recomputed.
+            vertex.g = INFINITY;
+            updateVertex(u);
+            for (auto &transition : vertices_[u].successors)
+            {
+                updateVertex(transition.target);
+            }
+        }
+    }
+}
+
+/* Backtrack the path from the root to the target and convert it into the assembly plan.
+    Every vertex on the path is consistent, its best predecessor is the one its rhs is taken from.
+**/
+std::vector<std::vector<Task *>> Replanner::backtrack()
+{
+    std::vector<std::vector<Task *>> assembly_plan;
+    path_.clear();
+
+    std::size_t v = target_ == npos ? goal_ : target_;
+    if (v == npos || vertices_[v].g == INFINITY)
+    {
+        std::cout << "No plan found." << std::endl;
+        return assembly_plan;
+    }
+
+    // The plan is executed from the target towards the root, which is the order of the backtracking.
+    path_.push_back(v);
+    while (v != 0)
+    {
+        const Link *best = nullptr;
+        double best_g = INFINITY;
+        for (auto &link : vertices_[v].predecessors)
+        {
+            double g = vertices_[link.source].g + link.edge->data_.cost;
+            if (g < best_g)
+            {
+                best_g = g;
+                best = &link;
+            }
+        }
+
+        std::vector<Task *> step;
+        for (auto &i : best->edge->data_.agent_actions_)
+        {
+            double cost = config_->cost(i.first->data_.config_index, config_->agentId(i.second));
+            step.push_back(new Task(i.first->data_.name, i.second, cost));
+        }
+        assembly_plan.push_back(step);
+        v = best->source;
+        path_.push_back(v);
+    }
+    std::reverse(path_.begin(), path_.end());
+
+    return assembly_plan;
+}
+
+/* Get the counters of the last call.
+**/
+const SearchStatistics &Replanner::statistics() const
+{
+    return statistics_;
+}
+
+/* Get the search cost of the last plan.
+**/
+double Replanner::cost() const
+{
+    if (path_.empty())
+        return INFINITY;
+    return vertices_[path_.back()].g;
+}
+
+/* Get the state the last search ended at.
+**/
+const SearchState *Replanner::target() const
+{
+    std::size_t v = target_ == npos ? goal_ : target_;
+    if (v == npos)
+        return nullptr;
+    return &vertices_[v].node->data_.state;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <sys/resource.h>
+
+#include "nlohmann/json.hpp"
+#include "planner.hpp"
+#include "plan_cache.hpp"
+
+/* Wall times of the phases of a planner run in milliseconds.
+**/
+struct PhaseTimes
+{
+    // Reading the XML input and compiling the configuration.
+    double parse = 0;
+    // Search and backtracking of the plan.
+    double plan = 0;
+    // Execution of the plan by the Supervisor.
+    double execute = 0;
+};
+
+// Conversion to JSON. Found by nlohmann::json through argument-dependent lookup.
+void to_json(nlohmann::json &, const SearchStatistics &);
+void to_json(nlohmann::json &, const ExpansionStatistics &);
+void to_json(nlohmann::json &, const PlanningStatistics &);
+void to_json(nlohmann::json &, const PhaseTimes &);
+void to_json(nlohmann::json &, const PlanCacheStatistics &);
+
+// Peak resident memory of the process in bytes.
+std::size_t peakResidentMemory();
+
+// Write the report of a planner run. "-" writes to std::cout.
+bool writeReport(const std::string &, const PlanningStatistics &, const PhaseTimes &, const PlanCacheStatistics * = nullptr);
+
+// Write the report of a planner run to a stream.
+void writeReport(std::ostream &, const PlanningStatistics &, const PhaseTimes &, const PlanCacheStatistics * = nullptr);
+
+void to_json(nlohmann::json &json, const SearchStatistics &statistics)
+{
+    json = nlohmann::json{{"expansions", statistics.expansions},
+                          {"generated", statistics.generated},
+                          {"queued", statistics.queued},
+                          {"duplicates", statistics.duplicates},
+                          {"peak_open", statistics.peak_open}};
+}
+
+void to_json(nlohmann::json &json, const ExpansionStatistics &statistics)
+{
+    json = nlohmann::json{{"assignments", statistics.assignments},
+                          {"interactions", statistics.interactions},
+                          {"interactions_reused", statistics.interactions_reused},
+                          {"pruned", statistics.pruned},
+                          {"prune_ratio", statistics.assignments ? double(statistics.pruned) / statistics.assignments : 0.0}};
+}
+
+void to_json(nlohmann::json &json, const PlanningStatistics &statistics)
+{
+    json = nlohmann::json{{"mode", statistics.mode},
+                          {"solved", statistics.solved},
+                          {"status", statistics.status},
+                          {"search_cost", statistics.search_cost},
+                          {"plan_cost", statistics.plan_cost},
+                          {"plan_steps", statistics.plan_steps},
+                          {"search", statistics.search},
+                          {"expansion", statistics.expansion},
+                          {"search_ms", statistics.search_time},
+                          {"arena_peak_bytes", statistics.arena_peak}};
+}
+
+void to_json(nlohmann::json &json, const PhaseTimes &times)
+{
+    json = nlohmann::json{{"parse_ms", times.parse},
+                          {"plan_ms", times.plan},
+                          {"execute_ms", times.execute},
+                          {"total_ms", times.parse + times.plan + times.execute}};
+}
+
+void to_json(nlohmann::json &json, const PlanCacheStatistics &statistics)
+{
+    json = nlohmann::json{{"hits", statistics.hits},
+                          {"misses", statistics.misses},
+                          {"stores", statistics.stores},
+                          {"evictions", statistics.evictions}};
+}
+
+/* Obtain the peak resident memory of the process.
+    \return: peak resident set size in bytes. Zero if it can not be determined.
+**/
+std::size_t peakResidentMemory()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    // Linux reports kilobytes.
+    return std::size_t(usage.ru_maxrss) * 1024;
+}
+
+/* Write the report of a planner run as JSON.
+    @path: output file. "-" writes to std::cout.
+    @statistics: statistics of the Planner.
+    @times: wall times of the phases.
+    @cache: counters of the plan cache. nullptr if no cache is used.
+    \return: false if the file could not be written.
+**/
+bool writeReport(const std::string &path, const PlanningStatistics &statistics, const PhaseTimes &times,
+                 const PlanCacheStatistics *cache)
+{
+    if (path == "-")
+    {
+        writeReport(std::cout, statistics, times, cache);
+        return true;
+    }
+
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Unable to write the report to " << path << "." << std::endl;
+        return false;
+    }
+    writeReport(file, statistics, times, cache);
+    return true;
+}
+
+/* Write the report of a planner run as JSON to a stream.
+    @stream: output stream.
+    @statistics: statistics of the Planner.
+    @times: wall times of the phases.
+    @cache: counters of the plan cache. nullptr if no cache is used.
+**/
+void writeReport(std::ostream &stream, const PlanningStatistics &statistics, const PhaseTimes &times,
+                 const PlanCacheStatistics *cache)
+{
+    nlohmann::json report = statistics;
+    report["time"] = times;
+    if (cache)
+        report["cache"] = *cache;
+    report["peak_rss_bytes"] = peakResidentMemory();
+
+    stream << report.dump(4) << std::endl;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// x86 kernels need the target attribute of GCC/Clang. Define SCORE_KERNEL_SCALAR to disable them.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(SCORE_KERNEL_SCALAR)
+#define SCORE_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+/* Scores of the successors of an expansion as structure of arrays.
+    The search fills the g_score and the components of the heuristic (Heuristic::components) for every child,
+    scoreBatch evaluates the whole batch in one pass and the search writes h_score and f_score back.
+**/
+struct ScoreBatch
+{
+    // Inputs
+    std::vector<double> g_score;
+    std::vector<double> total;
+    std::vector<double> critical_path;
+    std::vector<double> next_step;
+
+    // Outputs
+    std::vector<double> h_score;
+    std::vector<double> f_score;
+
+    void resize(std::size_t);
+    std::size_t size() const;
+};
+
+// Evaluate h = max(max(total / agents, critical_path), next_step) and f = g + h for every entry.
+void scoreBatch(ScoreBatch &, double);
+
+// Name of the kernel selected for this CPU: "avx2", "sse2" or "scalar".
+const char *scoreKernel();
+
+/* Resize all arrays. The buffers are kept, so a batch should be reused between the expansions.
+**/
+inline void
+ScoreBatch::resize(std::size_t size)
+{
+    for (auto array : {&g_score, &total, &critical_path, &next_step, &h_score, &f_score})
+        array->resize(size);
+}
+
+inline std::size_t
+ScoreBatch::size() const
+{
+    return g_score.size();
+}
+
+/* Portable kernel. Also evaluates the entries after the last full vector of the other kernels.
+    The operations are the same as in Heuristic::operator(), so every kernel produces the same bits.
+    @batch: batch to evaluate.
+    @agents: number of agents the summed lower bound is divided by.
+    @begin: first entry.
+**/
+inline void
+scoreScalar(ScoreBatch &batch, double agents, std::size_t begin = 0)
+{
+    std::size_t size = batch.size();
+    for (std::size_t i = begin; i < size; i++)
+    {
+        double h = std::max(std::max(batch.total[i] / agents, batch.critical_path[i]), batch.next_step[i]);
+        batch.h_score[i] = h;
+        batch.f_score[i] = batch.g_score[i] + h;
+    }
+}
+
+#ifdef SCORE_KERNEL_X86
+
+/* Kernel for two entries per instruction. SSE2 is part of every x86-64 CPU.
+**/
+__attribute__((target("sse2"))) inline void
+scoreSse2(ScoreBatch &batch, double agents)
+{
+    std::size_t size = batch.size();
+    std::size_t i = 0;
+    __m128d divisor = _mm_set1_pd(agents);
+    for (; i + 2 <= size; i += 2)
+    {
+        __m128d h = _mm_div_pd(_mm_loadu_pd(&batch.total[i]), divisor);
+        h = _mm_max_pd(h, _mm_loadu_pd(&batch.critical_path[i]));
+        h = _mm_max_pd(h, _mm_loadu_pd(&batch.next_step[i]));
+        _mm_storeu_pd(&batch.h_score[i], h);
+        _mm_storeu_pd(&batch.f_score[i], _mm_add_pd(_mm_loadu_pd(&batch.g_score[i]), h));
+    }
+    scoreScalar(batch, agents, i);
+}
+
+/* Kernel for four entries per instruction.
+**/
+__attribute__((target("avx2"))) inline void
+scoreAvx2(ScoreBatch &batch, double agents)
+{
+    std::size_t size = batch.size();
+    std::size_t i = 0;
+    __m256d divisor = _mm256_set1_pd(agents);
+    for (; i + 4 <= size; i += 4)
+    {
+        __m256d h = _mm256_div_pd(_mm256_loadu_pd(&batch.total[i]), divisor);
+        h = _mm256_max_pd(h, _mm256_loadu_pd(&batch.critical_path[i]));
+        h = _mm256_max_pd(h, _mm256_loadu_pd(&batch.next_step[i]));
+        _mm256_storeu_pd(&batch.h_score[i], h);
+        _mm256_storeu_pd(&batch.f_score[i], _mm256_add_pd(_mm256_loadu_pd(&batch.g_score[i]), h));
+    }
+    scoreScalar(batch, agents, i);
+}
+
+#endif
+
+typedef void (*ScoreFunction)(ScoreBatch &, double);
+
+/* Select the widest kernel supported by the CPU. Evaluated once.
+    @name: set to the name of the kernel.
+**/
+inline ScoreFunction
+selectScoreKernel(const char *&name)
+{
+#ifdef SCORE_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        name = "avx2";
+        return scoreAvx2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        name = "sse2";
+        return scoreSse2;
+    }
+#endif
+    name = "scalar";
+    return [](ScoreBatch &batch, double agents) { scoreScalar(batch, agents); };
+}
+
+/* Kernel of this CPU and its name. Initialized on the first use, which is thread-safe.
+**/
+struct ScoreDispatch
+{
+    const char *name;
+    ScoreFunction function;
+
+    ScoreDispatch() { function = selectScoreKernel(name); }
+
+    static const ScoreDispatch &get()
+    {
+        static const ScoreDispatch dispatch;
+        return dispatch;
+    }
+};
+
+/* Evaluate the h_score and f_score of a whole batch with the kernel selected for this CPU.
+    @batch: g_score, total, critical_path and next_step have to be set for every entry.
+    @agents: number of agents the summed lower bound is divided by.
+**/
+inline void
+scoreBatch(ScoreBatch &batch, double agents)
+{
+    ScoreDispatch::get().function(batch, agents);
+}
+
+inline const char *
+scoreKernel()
+{
+    return ScoreDispatch::get().name;
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Maximum number of nodes of the And/Or graph which can be represented by a SearchState.
+// Can be raised at compile time for larger assemblies.
+#ifndef SEARCH_STATE_MAX_NODES
+#define SEARCH_STATE_MAX_NODES 256
+#endif
+
+/* Compact state of a supernode of the A* search.
+    The remaining subassemblies and the open actions are stored as fixed-width bitsets
+    over the dense ids of the Or/And nodes of the original graph.
+    Subassemblies waiting for an interaction are stored as bits over the interaction slots
+    of the config::CompiledConfiguration.
+    A subassembly waiting for an interaction is only stored by its slot, its actions become open with the interaction.
+    The state is trivially copyable, so creating the state of a child supernode does not allocate.
+    Supernodes do not store their subassemblies otherwise. They are enumerated from the bits (forEachSubassembly).
+**/
+class SearchState
+{
+public:
+    static constexpr std::size_t capacity = SEARCH_STATE_MAX_NODES;
+
+    SearchState();
+
+    void addSubassembly(std::size_t);
+    void removeSubassembly(std::size_t);
+    bool hasSubassembly(std::size_t) const;
+
+    void addAction(std::size_t);
+    void removeAction(std::size_t);
+    bool hasAction(std::size_t) const;
+
+    void addInteraction(std::size_t);
+    void removeInteraction(std::size_t);
+    bool hasInteraction(std::size_t) const;
+
+    // Call a function with the id of every subassembly / the slot of every pending interaction, in ascending order.
+    template <typename Function>
+    void forEachSubassembly(Function) const;
+    template <typename Function>
+    void forEachInteraction(Function) const;
+
+    // True if neither an action nor an interaction remains.
+    bool isGoal() const;
+
+    std::size_t hash() const;
+    bool operator==(const SearchState &) const;
+    bool operator!=(const SearchState &) const;
+
+private:
+    static constexpr std::size_t words_ = (capacity + 63) / 64;
+    typedef std::array<std::uint64_t, words_> Bitset;
+
+    static void set(Bitset &, std::size_t);
+    static void reset(Bitset &, std::size_t);
+    static bool test(const Bitset &, std::size_t);
+    template <typename Function>
+    static void forEach(const Bitset &, Function);
+
+    Bitset subassemblies_;
+    Bitset interactions_;
+    Bitset actions_;
+};
+
+/* Constructor. Creates an empty state.
+**/
+inline SearchState::SearchState()
+{
+    subassemblies_.fill(0);
+    interactions_.fill(0);
+    actions_.fill(0);
+}
+
+/* Set the bit with the given index.
+**/
+inline void
+SearchState::set(Bitset &bits, std::size_t index)
+{
+    bits[index >> 6] |= std::uint64_t(1) << (index & 63);
+}
+
+/* Clear the bit with the given index.
+**/
+inline void
+SearchState::reset(Bitset &bits, std::size_t index)
+{
+    bits[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
+}
+
+/* Check the bit with the given index.
+**/
+inline bool
+SearchState::test(const Bitset &bits, std::size_t index)
+{
+    return (bits[index >> 6] >> (index & 63)) & 1;
+}
+
+/* Call a function with the index of every set bit, in ascending order.
+**/
+template <typename Function>
+inline void
+SearchState::forEach(const Bitset &bits, Function function)
+{
+    for (std::size_t i = 0; i < words_; i++)
+    {
+        for (std::uint64_t word = bits[i]; word != 0; word &= word - 1)
+            function(i * 64 + __builtin_ctzll(word));
+    }
+}
+
+/* Mark a subassembly as present.
+    @id: id of the Or node inside the original graph.
+**/
+inline void
+SearchState::addSubassembly(std::size_t id)
+{
+    set(subassemblies_, id);
+}
+
+/* Mark a subassembly as consumed.
+    @id: id of the Or node inside the original graph.
+**/
+inline void
+SearchState::removeSubassembly(std::size_t id)
+{
+    reset(subassemblies_, id);
+}
+
+/* Check if a subassembly is present.
+    @id: id of the Or node inside the original graph.
+**/
+inline bool
+SearchState::hasSubassembly(std::size_t id) const
+{
+    return test(subassemblies_, id);
+}
+
+/* Mark an action as available.
+    @id: id of the And node inside the original graph.
+**/
+inline void
+SearchState::addAction(std::size_t id)
+{
+    set(actions_, id);
+}
+
+/* Mark an action as no longer available.
+    @id: id of the And node inside the original graph.
+**/
+inline void
+SearchState::removeAction(std::size_t id)
+{
+    reset(actions_, id);
+}
+
+/* Check if an action is available.
+    @id: id of the And node inside the original graph.
+**/
+inline bool
+SearchState::hasAction(std::size_t id) const
+{
+    return test(actions_, id);
+}
+
+/* Mark a subassembly as waiting for an interaction.
+    @slot: interaction slot, identifies the subassembly and the interaction.
+**/
+inline void
+SearchState::addInteraction(std::size_t slot)
+{
+    set(interactions_, slot);
+}
+
+/* Mark the interaction of a subassembly as executed.
+    @slot: interaction slot, identifies the subassembly and the interaction.
+**/
+inline void
+SearchState::removeInteraction(std::size_t slot)
+{
+    reset(interactions_, slot);
+}
+
+/* Check if a subassembly waits for the interaction.
+    @slot: interaction slot, identifies the subassembly and the interaction.
+**/
+inline bool
+SearchState::hasInteraction(std::size_t slot) const
+{
+    return test(interactions_, slot);
+}
+
+/* Enumerate the present subassemblies. Subassemblies waiting for an interaction are not included.
+    @function: called with the id of the Or node inside the original graph.
+**/
+template <typename Function>
+inline void
+SearchState::forEachSubassembly(Function function) const
+{
+    forEach(subassemblies_, function);
+}
+
+/* Enumerate the subassemblies waiting for an interaction.
+    @function: called with the interaction slot.
+**/
+template <typename Function>
+inline void
+SearchState::forEachInteraction(Function function) const
+{
+    forEach(interactions_, function);
+}
+
+/* Check if the assembly is finished.
+    \return: true if no action is open and no interaction is pending.
+**/
+inline bool
+SearchState::isGoal() const
+{
+    for (std::size_t i = 0; i < words_; i++)
+    {
+        if (actions_[i] != 0 || interactions_[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+/* Calculate the hash of the state.
+    The open actions follow from the subassemblies and are not taken into account.
+    \return: hash of the remaining subassemblies and pending interactions.
+**/
+inline std::size_t
+SearchState::hash() const
+{
+    std::uint64_t hash = 0;
+    for (std::size_t i = 0; i < words_; i++)
+    {
+        hash = (hash ^ subassemblies_[i]) * 0x9e3779b97f4a7c15ULL;
+        hash = (hash ^ interactions_[i]) * 0x9e3779b97f4a7c15ULL;
+    }
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/* Compare two states.
+    The open actions follow from the subassemblies and are not taken into account.
+    \return: true if both contain the same subassemblies and pending interactions.
+**/
+inline bool
+SearchState::operator==(const SearchState &other) const
+{
+    return subassemblies_ == other.subassemblies_ && interactions_ == other.interactions_;
+}
+
+inline bool
+SearchState::operator!=(const SearchState &other) const
+{
+    return !(*this == other);
+}
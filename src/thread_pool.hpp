@@ -0,0 +1,230 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+/* Work-stealing thread pool for data-parallel loops.
+    parallelFor() splits an index range into chunks, which are distributed round-robin over
+    one queue per thread. Every thread takes chunks from the back of its own queue and steals
+    from the front of the other queues once its own queue is empty.
+    The calling thread works as thread 0, so a pool of size N starts N - 1 threads.
+**/
+class ThreadPool
+{
+public:
+    ThreadPool(std::size_t);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Number of threads including the calling one.
+    std::size_t size() const;
+
+    // Call function(begin, end, thread) for all chunks of [0, n). Returns once all chunks are done.
+    void parallelFor(std::size_t, std::size_t, const std::function<void(std::size_t, std::size_t, std::size_t)> &);
+
+private:
+    struct Range
+    {
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    void run(std::size_t);
+    void work(std::size_t);
+    bool pop(std::size_t, Range &);
+    bool steal(std::size_t, Range &);
+
+    std::vector<std::thread> threads_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    // Loop body of the current parallelFor() and the number of its chunks which are not done.
+    const std::function<void(std::size_t, std::size_t, std::size_t)> *job_;
+    std::atomic<std::size_t> pending_;
+
+    // First exception thrown by a chunk. Rethrown by parallelFor().
+    std::exception_ptr exception_;
+    std::mutex exception_mutex_;
+
+    // Wakes the threads when a new parallelFor() starts.
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::size_t generation_;
+    bool stop_;
+};
+
+/* Constructor. Starts the threads.
+    @threads: number of threads including the calling one.
+**/
+inline ThreadPool::ThreadPool(std::size_t threads)
+    : job_(nullptr), pending_(0), generation_(0), stop_(false)
+{
+    if (threads == 0)
+        threads = 1;
+
+    for (std::size_t i = 0; i < threads; i++)
+        queues_.emplace_back(new Queue());
+    for (std::size_t i = 1; i < threads; i++)
+        threads_.emplace_back(&ThreadPool::run, this, i);
+}
+
+/* Destructor. Stops and joins the threads.
+**/
+inline ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &thread : threads_)
+        thread.join();
+}
+
+inline std::size_t
+ThreadPool::size() const
+{
+    return queues_.size();
+}
+
+/* Execute a loop in parallel.
+    @n: number of iterations.
+    @grain: number of iterations per chunk.
+    @function: called with the range [begin, end) of a chunk and the index of the executing thread.
+**/
+inline void
+ThreadPool::parallelFor(std::size_t n, std::size_t grain,
+                        const std::function<void(std::size_t, std::size_t, std::size_t)> &function)
+{
+    if (grain == 0)
+        grain = 1;
+
+    if (size() == 1 || n <= grain)
+    {
+        if (n > 0)
+            function(0, n, 0);
+        return;
+    }
+
+    // A thread of the previous call can still be looking for chunks and take one of the new ones
+    // as soon as it is pushed. The job and the counter have to be set before.
+    job_ = &function;
+    {
+        std::lock_guard<std::mutex> lock(exception_mutex_);
+        exception_ = nullptr;
+    }
+    pending_.store((n + grain - 1) / grain, std::memory_order_release);
+
+    std::size_t chunks = 0;
+    for (std::size_t begin = 0; begin < n; begin += grain, chunks++)
+    {
+        Queue &queue = *queues_[chunks % size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.ranges.push_back(Range{begin, std::min(begin + grain, n)});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation_++;
+    }
+    wake_.notify_all();
+
+    work(0);
+
+    // Chunks stolen by the other threads may still be running.
+    while (pending_.load(std::memory_order_acquire) != 0)
+        std::this_thread::yield();
+
+    if (exception_)
+        std::rethrow_exception(exception_);
+}
+
+/* Main loop of a pool thread. Sleeps until parallelFor() distributes new chunks.
+    @index: index of the thread.
+**/
+inline void
+ThreadPool::run(std::size_t index)
+{
+    std::size_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != generation; });
+            if (stop_)
+                return;
+            generation = generation_;
+        }
+        work(index);
+    }
+}
+
+/* Execute chunks until no queue contains any.
+    @index: index of the executing thread.
+**/
+inline void
+ThreadPool::work(std::size_t index)
+{
+    Range range;
+    while (pop(index, range) || steal(index, range))
+    {
+        try
+        {
+            (*job_)(range.begin, range.end, index);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(exception_mutex_);
+            if (!exception_)
+                exception_ = std::current_exception();
+        }
+        pending_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+/* Take a chunk from the back of the own queue.
+**/
+inline bool
+ThreadPool::pop(std::size_t index, Range &range)
+{
+    Queue &queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty())
+        return false;
+    range = queue.ranges.back();
+    queue.ranges.pop_back();
+    return true;
+}
+
+/* Steal a chunk from the front of another queue.
+**/
+inline bool
+ThreadPool::steal(std::size_t index, Range &range)
+{
+    for (std::size_t i = 1; i < size(); i++)
+    {
+        Queue &queue = *queues_[(index + i) % size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.ranges.empty())
+            continue;
+        range = queue.ranges.front();
+        queue.ranges.pop_front();
+        return true;
+    }
+    return false;
+}
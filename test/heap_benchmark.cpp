@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <queue>
+#include <random>
+#include <chrono>
+
+#include "graph.hpp"
+#include "arena.hpp"
+#include "indexed_heap.hpp"
+
+/* Benchmark of the open-set of the A* search.
+    Compares std::priority_queue, which has to push a copy for every improved path, with the indexed 4-ary heap,
+    which updates the priority in place.
+    Usage: heap_benchmark [size...]   Default sizes: 1000000 3000000 10000000.
+    Every supernode needs about 400 bytes, 10^7 entries need about 4 GB.
+**/
+
+struct LessThan
+{
+    bool operator()(const Node *lhs, const Node *rhs) const
+    {
+        return (lhs->data_.f_score) > (rhs->data_.f_score);
+    }
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double milliseconds(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(std::stoul(argv[i]));
+    if (sizes.empty())
+        sizes = {1000000, 3000000, 10000000};
+
+    printf("%10s  %-16s %12s %12s %12s %12s\n", "entries", "open-set", "push [ms]", "bulk [ms]", "improve [ms]", "pop [ms]");
+
+    for (auto n : sizes)
+    {
+        Arena arena;
+        std::vector<Node *> nodes;
+        nodes.reserve(n);
+        std::mt19937_64 random(42);
+        std::uniform_real_distribution<double> score(0, 1000);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            NodeData data;
+            data.f_score = score(random);
+            nodes.push_back(arena.create<Node>(i, data));
+        }
+
+        // Every tenth supernode is reached again through a path which is cheaper by a random amount.
+        std::vector<std::pair<Node *, double>> improvements;
+        for (std::size_t i = 0; i < n; i += 10)
+            improvements.emplace_back(nodes[i], nodes[i]->data_.f_score * score(random) / 1000);
+
+        // std::priority_queue. Improved supernodes are pushed again, the stale copy is skipped when popped.
+        {
+            std::vector<double> original(n);
+            for (std::size_t i = 0; i < n; i++)
+                original[i] = nodes[i]->data_.f_score;
+
+            auto start = Clock::now();
+            std::priority_queue<Node *, std::vector<Node *>, LessThan> queue;
+            for (auto node : nodes)
+                queue.push(node);
+            double push = milliseconds(start);
+
+            start = Clock::now();
+            std::priority_queue<Node *, std::vector<Node *>, LessThan> bulk(LessThan(), nodes);
+            double heapify = milliseconds(start);
+
+            // The A* search would push a new supernode, here the same one is pushed again.
+            start = Clock::now();
+            for (auto &improvement : improvements)
+            {
+                improvement.first->data_.f_score = improvement.second;
+                queue.push(improvement.first);
+            }
+            double improve = milliseconds(start);
+
+            start = Clock::now();
+            std::size_t popped = 0;
+            while (!queue.empty())
+            {
+                queue.pop();
+                popped++;
+            }
+            double pop = milliseconds(start);
+
+            printf("%10zu  %-16s %12.1f %12.1f %12.1f %12.1f   (%zu pops)\n", n, "priority_queue", push, heapify, improve, pop, popped);
+
+            for (std::size_t i = 0; i < n; i++)
+                nodes[i]->data_.f_score = original[i];
+        }
+
+        // Indexed 4-ary heap. Improved supernodes are updated in place.
+        {
+            IndexedHeap<LessThan> heap;
+            auto start = Clock::now();
+            heap.pushAll(nodes);
+            double heapify = milliseconds(start);
+
+            // A supernode can only be part of one heap at a time.
+            heap.clear();
+            start = Clock::now();
+            for (auto node : nodes)
+                heap.push(node);
+            double push = milliseconds(start);
+
+            start = Clock::now();
+            for (auto &improvement : improvements)
+            {
+                improvement.first->data_.f_score = improvement.second;
+                heap.update(improvement.first);
+            }
+            double improve = milliseconds(start);
+
+            start = Clock::now();
+            std::size_t popped = 0;
+            while (!heap.empty())
+            {
+                heap.pop();
+                popped++;
+            }
+            double pop = milliseconds(start);
+
+            printf("%10zu  %-16s %12.1f %12.1f %12.1f %12.1f   (%zu pops)\n", n, "IndexedHeap<4>", push, heapify, improve, pop, popped);
+        }
+
+        for (auto node : nodes)
+            node->~Node();
+    }
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <cmath>
+
+#include "input_reader.hpp"
+#include "compiled_configuration.hpp"
+#include "replanner.hpp"
+
+/* Check of the incremental replanning.
+    Plans every input with the Replanner. Every round applies a random delta of the costs and the reachability,
+    executes a random number of steps of the last plan and calls replan(). Its cost is compared with a cold
+    Dijkstra search to the same target state, on tables compiled again from the input with all deltas applied.
+    Usage: replanner_check [assembly.xml...] [--rounds N]   Default: example_assembly.xml, 20 rounds.
+**/
+
+typedef std::chrono::steady_clock Clock;
+
+double milliseconds(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void apply(config::CompiledConfiguration &tables, const ConfigurationDelta &delta)
+{
+    for (auto &change : delta.costs)
+        tables.setCost(change.action, change.agent, change.cost);
+    for (auto &change : delta.reachability)
+        tables.setReachable(change.subassembly, change.agent, change.reachable, change.interaction);
+}
+
+/* Random change of the configuration.
+    Up to three finite costs are scaled by a factor in [0.5, 2]. Every second delta also flips the reachability
+    of a subassembly for an agent. Unreachable subassemblies need one of the interactions of the input.
+**/
+ConfigurationDelta randomDelta(const config::CompiledConfiguration &tables, const std::vector<std::size_t> &interactions,
+                               std::mt19937_64 &random)
+{
+    ConfigurationDelta delta;
+    std::uniform_int_distribution<std::size_t> action(0, tables.numberOfActions() - 1);
+    std::uniform_int_distribution<std::size_t> agent(0, tables.numberOfAgents() - 1);
+    std::uniform_int_distribution<std::size_t> subassembly(0, tables.numberOfSubassemblies() - 1);
+    std::uniform_real_distribution<double> factor(0.5, 2);
+
+    std::size_t changes = std::uniform_int_distribution<std::size_t>(1, 3)(random);
+    for (std::size_t i = 0; i < changes; i++)
+    {
+        std::size_t a = action(random);
+        std::size_t r = agent(random);
+        double cost = tables.cost(a, r);
+        if (std::isfinite(cost))
+            delta.costs.push_back({a, r, cost * factor(random)});
+    }
+
+    if (random() % 2)
+    {
+        std::size_t s = subassembly(random);
+        std::size_t r = agent(random);
+        if (!tables.reachable(s, r))
+            delta.reachability.push_back({s, r, true, 0});
+        else if (!interactions.empty())
+            delta.reachability.push_back({s, r, false, interactions[random() % interactions.size()]});
+    }
+    return delta;
+}
+
+/* Cost of the cheapest path from the root to a state, searched from scratch.
+    @target: state to reach. nullptr for any goal.
+    \return: search cost. INFINITY if the state can not be reached.
+**/
+double coldSearch(Graph<> *graph, config::CompiledConfiguration *tables, const SearchState *target)
+{
+    CsrGraph original(graph);
+    Arena arena;
+    Graph<> search_graph(&arena);
+    NodeExpander expander(&search_graph, tables, &original);
+    // The Replanner keeps the dominated transitions, the reference searches the same transitions.
+    expander.setDominancePruning(false);
+
+    Node *root = search_graph.insertNode(graph->root_->data_);
+    root->data_.state.addSubassembly(graph->root_->id_);
+    for (auto x : graph->root_->successorNodes())
+        root->data_.state.addAction(x->id_);
+    root->data_.g_score = 0;
+    root->data_.f_score = 0;
+    root->data_.marked = false;
+
+    TranspositionTable best;
+    SearchStatistics statistics;
+    best.insert(root, statistics);
+    std::priority_queue<Node *, std::vector<Node *>, LessThan> open;
+    open.push(root);
+
+    while (!open.empty())
+    {
+        Node *node = open.top();
+        open.pop();
+        if (node->data_.marked || best.find(node) != node)
+            continue;
+        node->data_.marked = true;
+
+        if (target ? node->data_.state == *target : node->data_.isGoal())
+            return node->data_.g_score;
+        if (node->data_.isGoal())
+            continue;
+
+        expander.expandNode(node);
+        for (auto edge : node->successors())
+        {
+            Node *child = edge->getDestination();
+            child->data_.g_score = node->data_.g_score + edge->data_.cost;
+            child->data_.f_score = child->data_.g_score;
+            child->data_.marked = false;
+            if (best.insert(child, statistics))
+                open.push(child);
+        }
+    }
+    return INFINITY;
+}
+
+bool same(double lhs, double rhs)
+{
+    if (std::isinf(lhs) || std::isinf(rhs))
+        return lhs == rhs;
+    return std::fabs(lhs - rhs) <= 1e-9 * std::max(1.0, std::fabs(rhs));
+}
+
+void release(std::vector<std::vector<Task *>> &plan)
+{
+    for (auto &step : plan)
+        for (auto task : step)
+            delete task;
+    plan.clear();
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> inputs;
+    std::size_t rounds = 20;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--rounds" && i + 1 < argc)
+            rounds = std::stoul(argv[++i]);
+        else
+            inputs.push_back(argv[i]);
+    }
+    if (inputs.empty())
+        inputs = {"example_assembly.xml"};
+
+    printf("%-24s %6s %9s %14s %14s %12s %12s   %s\n",
+           "input", "round", "executed", "replan cost", "cold cost", "replan [ms]", "cold [ms]", "result");
+
+    int failures = 0;
+    for (auto &input : inputs)
+    {
+        Graph<> *assembly;
+        config::Configuration *config;
+        bool result;
+        InputReader reader(input);
+        std::tie(assembly, config, result) = reader.read("assembly");
+        if (!result)
+        {
+            printf("%-24s could not be read\n", input.c_str());
+            failures++;
+            continue;
+        }
+
+        config::CompiledConfiguration tables(config, assembly);
+        std::vector<std::size_t> interactions;
+        for (std::size_t s = 0; s < tables.numberOfSubassemblies(); s++)
+            for (std::size_t r = 0; r < tables.numberOfAgents(); r++)
+                if (!tables.reachable(s, r))
+                    interactions.push_back(tables.interaction(s, r));
+
+        Replanner replanner(assembly, assembly->root_, &tables);
+        std::mt19937_64 random(42);
+        std::vector<ConfigurationDelta> deltas;
+
+        auto start = Clock::now();
+        auto plan = replanner.plan();
+        double replan_time = milliseconds(start);
+
+        for (std::size_t round = 0; round <= rounds; round++)
+        {
+            std::size_t executed = 0;
+            if (round > 0)
+            {
+                // Keep at least one step of the last plan, the assembly would be complete otherwise.
+                if (plan.size() < 2)
+                    break;
+                executed = std::uniform_int_distribution<std::size_t>(0, plan.size() - 2)(random);
+                deltas.push_back(randomDelta(tables, interactions, random));
+
+                release(plan);
+                start = Clock::now();
+                plan = replanner.replan(deltas.back(), executed);
+                replan_time = milliseconds(start);
+            }
+
+            config::CompiledConfiguration fresh(config, assembly);
+            for (auto &delta : deltas)
+                apply(fresh, delta);
+            start = Clock::now();
+            double cold = coldSearch(assembly, &fresh, round > 0 ? replanner.target() : nullptr);
+            double cold_time = milliseconds(start);
+
+            bool ok = same(replanner.cost(), cold);
+            failures += !ok;
+            printf("%-24s %6zu %9zu %14.4f %14.4f %12.3f %12.3f   %s\n", input.c_str(), round, executed,
+                   replanner.cost(), cold, replan_time, cold_time, ok ? "ok" : "MISMATCH");
+
+            if (std::isinf(replanner.cost()))
+                break;
+        }
+        release(plan);
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+
+#include "score_kernel.hpp"
+
+/* Benchmark of the batch f-score kernels of the A* search.
+    Evaluates batches of the size of an expansion with every kernel supported by this CPU
+    and checks that they produce the same bits as the scalar one.
+    Usage: score_benchmark [batch size...]   Default sizes: 16 64 256 4096.
+**/
+
+typedef std::chrono::steady_clock Clock;
+
+double nanoseconds(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+struct Kernel
+{
+    const char *name;
+    ScoreFunction function;
+};
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(std::stoul(argv[i]));
+    if (sizes.empty())
+        sizes = {16, 64, 256, 4096};
+
+    std::vector<Kernel> kernels = {{"scalar", [](ScoreBatch &batch, double agents) { scoreScalar(batch, agents); }}};
+#ifdef SCORE_KERNEL_X86
+    if (__builtin_cpu_supports("sse2"))
+        kernels.push_back({"sse2", scoreSse2});
+    if (__builtin_cpu_supports("avx2"))
+        kernels.push_back({"avx2", scoreAvx2});
+#endif
+
+    printf("Selected kernel: %s\n", scoreKernel());
+    printf("%10s  %-8s %14s   %s\n", "batch", "kernel", "ns / entry", "result");
+
+    int failures = 0;
+    for (auto size : sizes)
+    {
+        ScoreBatch batch;
+        batch.resize(size);
+        std::mt19937_64 random(42);
+        std::uniform_real_distribution<double> score(0, 100);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            batch.g_score[i] = score(random);
+            batch.total[i] = score(random) * 3;
+            batch.critical_path[i] = score(random);
+            batch.next_step[i] = score(random) / 2;
+        }
+
+        // Repeat small batches, so every measurement covers about 10^7 entries.
+        std::size_t repetitions = std::max<std::size_t>(10000000 / size, 1);
+        std::vector<double> reference;
+        for (auto &kernel : kernels)
+        {
+            auto start = Clock::now();
+            for (std::size_t r = 0; r < repetitions; r++)
+                kernel.function(batch, 3);
+            double time = nanoseconds(start) / (double(repetitions) * size);
+
+            if (reference.empty())
+                reference = batch.f_score;
+            bool same = std::memcmp(reference.data(), batch.f_score.data(), size * sizeof(double)) == 0;
+            failures += !same;
+            printf("%10zu  %-8s %14.3f   %s\n", size, kernel.name, time, same ? "ok" : "MISMATCH");
+        }
+    }
+
+    return failures ? 1 : 0;
+}